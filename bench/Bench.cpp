@@ -0,0 +1,213 @@
+// hyprpicker-bench: runs synthetic frames through the capture conversion and the per-frame rendering helpers hyprpicker uses,
+// into plain memory, so they can be measured without a compositor.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <getopt.h>
+#include <print>
+#include <string>
+#include <vector>
+#include <wayland-client.h>
+
+#include "src/helpers/Overlay.hpp"
+#include "src/helpers/PixelConvert.hpp"
+#include "src/helpers/Resample.hpp"
+#include "src/helpers/ScreenBuffer.hpp"
+#include "src/helpers/TextAtlas.hpp"
+#include "src/helpers/WorkerPool.hpp"
+#include "tests/Synthetic.hpp"
+
+constexpr const char* TRANSFORMS[] = {"normal", "90", "180", "270", "flipped", "flipped-90", "flipped-180", "flipped-270"};
+
+struct SSize {
+    uint32_t    width, height;
+    const char* name;
+};
+
+constexpr SSize  SIZES[] = {{1920, 1080, "1080p"}, {2560, 1440, "1440p"}, {3840, 2160, "4K"}, {7680, 4320, "8K"}};
+
+constexpr double SCALES[] = {1.0, 1.25, 1.5, 2.0};
+
+// lens radii in buffer pixels: the default 10 source pixels at 10x, and a small and a large one
+constexpr double LENS_RADII[] = {50, 100, 200};
+
+static double    msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// every format at every size and transform, converted the way a capture is before the first frame
+static void benchConvert(CWorkerPool* pool, int iterations) {
+    std::println("{:<8} {:<12} {:<7} {:<12} {:>10} {:>12}", "convert", "format", "size", "transform", "ms", "MPix/s");
+
+    for (const auto& SIZE : SIZES) {
+        for (const auto& FORMAT : FORMATS) {
+            const uint32_t STRIDE = SIZE.width * NPixelConvert::bytesPerPixel(FORMAT.format);
+            auto           frame  = randomBytes((size_t)STRIDE * SIZE.height, 0x12345678);
+
+            for (uint32_t transform = 0; transform < 8; ++transform) {
+                double best = INFINITY;
+
+                for (int i = 0; i < iterations; ++i) {
+                    const auto    START = std::chrono::steady_clock::now();
+
+                    CScreenBuffer screen(frame.data(), Vector2D{(double)SIZE.width, (double)SIZE.height}, STRIDE, FORMAT.format, transform);
+                    screen.ensureAll(pool);
+
+                    best = std::min(best, msSince(START));
+                }
+
+                std::println("{:<8} {:<12} {:<7} {:<12} {:>10.3f} {:>12.1f}", "", FORMAT.name, SIZE.name, TRANSFORMS[transform], best,
+                             (double)SIZE.width * SIZE.height / 1000.0 / best);
+            }
+        }
+    }
+}
+
+// The overlay around center as hyprpicker draws it, with a preview label and the default 10 source pixel radius at radius.
+// Adds what it painted to damage.
+static void drawOverlay(const NResample::SImage& screen, cairo_t* cr, CTextAtlas& text, const Vector2D& canvasSize, const Vector2D& center, double radius, double scale,
+                        CRegion& damage) {
+    NOverlay::draw(cr, canvasSize, screen,
+                   {.srcPixel      = center * scale,
+                    .srcPerCanvas  = {scale, scale},
+                    .center        = center,
+                    .radius        = radius,
+                    .magnification = radius / 10.0,
+                    .color         = CColor{.r = 0x1A, .g = 0x2B, .b = 0x3C, .a = 0xFF},
+                    .label         = "#1A2B3C",
+                    .text          = &text},
+                   damage);
+}
+
+// A converted capture displayed at a buffer scale, the first (full) frame and then frames with the lens moving:
+// restore the background under the last overlay, paint the new one.
+static void benchRender(CWorkerPool* pool, int frames) {
+    std::println("\n{:<8} {:<7} {:<6} {:<6} {:>12} {:>12} {:>12}", "render", "size", "scale", "lens", "resample ms", "full ms", "frame ms");
+
+    CTextAtlas text("monospace", 18);
+
+    for (const auto& SIZE : SIZES) {
+        const uint32_t STRIDE = SIZE.width * 4;
+        auto           frame  = randomBytes((size_t)STRIDE * SIZE.height, 0x12345678);
+
+        CScreenBuffer  screen(frame.data(), Vector2D{(double)SIZE.width, (double)SIZE.height}, STRIDE, WL_SHM_FORMAT_XRGB8888, WL_OUTPUT_TRANSFORM_NORMAL);
+        screen.ensureAll(pool);
+
+        const NResample::SImage SCREEN = {.data = (uint8_t*)screen.data, .width = SIZE.width, .height = SIZE.height, .stride = screen.stride};
+
+        for (const double SCALE : SCALES) {
+            // without fractional scaling the buffer is the logical size times the next integer scale, which needs resampling
+            const Vector2D        LOGICAL = (Vector2D{(double)SIZE.width, (double)SIZE.height} / SCALE).round();
+            const Vector2D        BUFSIZE = LOGICAL * std::ceil(SCALE);
+
+            std::vector<uint8_t>  backgroundData((size_t)BUFSIZE.x * 4 * BUFSIZE.y);
+            std::vector<uint8_t>  bufferData(backgroundData.size());
+            NResample::SImage     background = SCREEN;
+            const NResample::SImage BUFFER   = {.data = bufferData.data(), .width = (uint32_t)BUFSIZE.x, .height = (uint32_t)BUFSIZE.y, .stride = (uint32_t)BUFSIZE.x * 4};
+
+            double                  resampleMs = 0;
+            if (BUFSIZE != Vector2D{(double)SIZE.width, (double)SIZE.height}) {
+                background = {.data = backgroundData.data(), .width = BUFFER.width, .height = BUFFER.height, .stride = BUFFER.stride};
+
+                const auto START = std::chrono::steady_clock::now();
+                NResample::area(SCREEN, background, pool);
+                resampleMs = msSince(START);
+            }
+
+            const auto SURFACE = cairo_image_surface_create_for_data(BUFFER.data, CAIRO_FORMAT_ARGB32, BUFFER.width, BUFFER.height, BUFFER.stride);
+            const auto CR      = cairo_create(SURFACE);
+            const double SRCPERBUF = SIZE.width / BUFSIZE.x;
+
+            for (const double RADIUS : LENS_RADII) {
+                auto START = std::chrono::steady_clock::now();
+
+                NResample::copy(background, BUFFER, nullptr, pool);
+                cairo_surface_mark_dirty(SURFACE);
+                CRegion      last;
+                drawOverlay(SCREEN, CR, text, BUFSIZE, BUFSIZE / 2, RADIUS, SRCPERBUF, last);
+
+                const double FULLMS = msSince(START);
+
+                START = std::chrono::steady_clock::now();
+                for (int i = 0; i < frames; ++i) {
+                    const auto CENTER = Vector2D{BUFSIZE.x / 2 + 200 * std::cos(i * 0.05), BUFSIZE.y / 2 + 200 * std::sin(i * 0.05)}.floor();
+
+                    NResample::copy(background, BUFFER, &last, pool);
+                    cairo_surface_mark_dirty(SURFACE);
+                    last.clear();
+                    drawOverlay(SCREEN, CR, text, BUFSIZE, CENTER, RADIUS, SRCPERBUF, last);
+                }
+
+                std::println("{:<8} {:<7} {:<6} {:<6} {:>12.3f} {:>12.3f} {:>12.3f}", "", SIZE.name, SCALE, RADIUS, resampleMs, FULLMS, msSince(START) / frames);
+            }
+
+            cairo_destroy(CR);
+            cairo_surface_destroy(SURFACE);
+        }
+    }
+}
+
+static void help() {
+    std::println("Usage: hyprpicker-bench [arg [...]]\n\nArguments:\n"
+                 " -i | --iterations=n       | Conversions per case, the fastest is reported (default: 5)\n"
+                 " -f | --frames=n           | Frames rendered per case (default: 200)\n"
+                 " -j | --threads=n          | Threads for per-pixel work (default: one per core)\n"
+                 " -b | --backend=name       | Pixel kernels: scalar, sse2, ssse3 or avx2 (default: best supported)\n"
+                 " -h | --help               | Show this help message");
+}
+
+int main(int argc, char** argv) {
+    int    iterations = 5, frames = 200;
+    size_t threads = 0;
+
+    while (true) {
+        static struct option long_options[] = {{"iterations", required_argument, nullptr, 'i'},
+                                               {"frames", required_argument, nullptr, 'f'},
+                                               {"threads", required_argument, nullptr, 'j'},
+                                               {"backend", required_argument, nullptr, 'b'},
+                                               {"help", no_argument, nullptr, 'h'},
+                                               {nullptr, 0, nullptr, 0}};
+
+        const int            c = getopt_long(argc, argv, "i:f:j:b:h", long_options, nullptr);
+        if (c == -1)
+            break;
+
+        switch (c) {
+            case 'i': iterations = std::max(1, atoi(optarg)); break;
+            case 'f': frames = std::max(1, atoi(optarg)); break;
+            case 'j': threads = std::max(0, atoi(optarg)); break;
+            case 'b': {
+                bool found = false;
+                for (int b = NPixelConvert::BACKEND_SCALAR; b <= NPixelConvert::BACKEND_AVX2; ++b) {
+                    if (strcmp(optarg, NPixelConvert::backendName((NPixelConvert::eBackend)b)) != 0)
+                        continue;
+
+                    found = true;
+                    if (!NPixelConvert::setBackend((NPixelConvert::eBackend)b)) {
+                        std::println(stderr, "This CPU can't run the {} kernels", optarg);
+                        return 1;
+                    }
+                }
+
+                if (!found) {
+                    help();
+                    return 1;
+                }
+                break;
+            }
+            case 'h': help(); return 0;
+            default: help(); return 1;
+        }
+    }
+
+    CWorkerPool pool(threads);
+
+    std::println("backend {}, {} threads\n", NPixelConvert::backendName(NPixelConvert::backend()), pool.threads());
+
+    benchConvert(&pool, iterations);
+    benchRender(&pool, frames);
+
+    return 0;
+}
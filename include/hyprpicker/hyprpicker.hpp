@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// libhyprpicker: screen capture, pixel sampling and color formatting, as used by the hyprpicker CLI, for use in-process.
+// Nothing here touches global state: every CCapture holds its own wayland connection, every CFrame its own pixels.
+// None of the objects are thread-safe, use each one from one thread at a time.
+namespace Hyprpicker {
+    struct SColor {
+        uint8_t r = 0, g = 0, b = 0, a = 0;
+    };
+
+    enum eFormat : uint8_t {
+        FORMAT_HEX = 0,
+        FORMAT_RGB,
+        FORMAT_HSL,
+        FORMAT_HSV,
+        FORMAT_CMYK,
+    };
+
+    // the text hyprpicker prints for a color, e.g. "#1A2B3C", "26 43 60", "210 40% 17%"
+    std::string format(const SColor& color, eFormat fmt, bool lowercaseHex = false);
+
+    // h in degrees, the rest in percent, all rounded like format() prints them
+    void        toHSL(const SColor& color, float& h, float& s, float& l);
+    void        toHSV(const SColor& color, float& h, float& s, float& v);
+    void        toCMYK(const SColor& color, float& c, float& m, float& y, float& k);
+
+    // A still image: a capture of an output, an image file or pixels handed in by the caller.
+    // Pixels are converted to ARGB32 and put upright lazily, the first time something reads them.
+    class CFrame {
+      public:
+        // copies a frame in any wl_shm format hyprpicker can read, in the orientation of a wl_output_transform.
+        // nullptr if the format isn't supported.
+        static std::unique_ptr<CFrame> fromMemory(const void* data, uint32_t width, uint32_t height, uint32_t stride, uint32_t shmFormat, uint32_t transform = 0);
+        // a binary PPM, 8-bit PAM, farbfeld or JPEG image. nullptr if it can't be read, with the reason in error if given.
+        static std::unique_ptr<CFrame> fromFile(const std::string& path, std::string* error = nullptr);
+
+        ~CFrame();
+
+        // upright size, in pixels
+        uint32_t width() const;
+        uint32_t height() const;
+
+        // transparent black outside of the frame
+        SColor   at(int x, int y) const;
+        // the average of the pixels of a rect that lie inside the frame, transparent black if none do
+        SColor   average(int x, int y, int w, int h) const;
+
+        // ARGB32 (B, G, R, A in memory) rows of width() pixels, converting whatever is left first
+        const uint8_t* pixels() const;
+        uint32_t       stride() const;
+
+        struct SImpl;
+
+      private:
+        CFrame(std::unique_ptr<SImpl> impl);
+
+        friend class CCapture;
+
+        std::unique_ptr<SImpl> m_impl;
+    };
+
+    struct SOutput {
+        std::string name;
+        // in the global logical space
+        int32_t     x = 0, y = 0, width = 0, height = 0;
+        int32_t     scale     = 1;
+        uint32_t    transform = 0;
+    };
+
+    // A connection to the compositor for taking screenshots with wlr-screencopy, without any surfaces of its own.
+    class CCapture {
+      public:
+        // connects to $WAYLAND_DISPLAY, or to display if given
+        CCapture(const char* display = nullptr);
+        ~CCapture();
+
+        // false if the connection or a required global is missing, or the connection broke, error() says why
+        bool                        good() const;
+        const std::string&          error() const;
+
+        const std::vector<SOutput>& outputs() const;
+
+        // the whole output, at its pixel resolution. nullptr on failure.
+        std::unique_ptr<CFrame>     captureOutput(const std::string& name, bool withCursor = false);
+        // a rect in global logical coordinates on the output containing its top-left corner, at that output's pixel resolution
+        std::unique_ptr<CFrame>     captureRegion(int32_t x, int32_t y, int32_t width, int32_t height, bool withCursor = false);
+        // like captureRegion, into one buffer that is kept and reused for as long as the compositor asks for the same size and format,
+        // for sampling the same region over and over. The frame stays owned by this object and is only valid until the next call.
+        const CFrame*               recaptureRegion(int32_t x, int32_t y, int32_t width, int32_t height, bool withCursor = false);
+
+        struct SImpl;
+
+      private:
+        std::unique_ptr<SImpl> m_impl;
+    };
+};
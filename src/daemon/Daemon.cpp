@@ -0,0 +1,157 @@
+#include "Daemon.hpp"
+
+#include "../debug/Log.hpp"
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+constexpr const char* REQUEST_PICK = "pick\n";
+
+std::string NDaemon::socketPath() {
+    const auto XDGRUNTIMEDIR = getenv("XDG_RUNTIME_DIR");
+    if (!XDGRUNTIMEDIR)
+        return "";
+
+    const auto WAYLANDDISPLAY = getenv("WAYLAND_DISPLAY");
+    return std::string(XDGRUNTIMEDIR) + "/hyprpicker-" + (WAYLANDDISPLAY ? WAYLANDDISPLAY : "wayland-0") + ".sock";
+}
+
+static bool fillAddress(const std::string& path, sockaddr_un& addr) {
+    addr            = {};
+    addr.sun_family = AF_UNIX;
+
+    if (path.empty() || path.length() >= sizeof(addr.sun_path))
+        return false;
+
+    strcpy(addr.sun_path, path.c_str());
+    return true;
+}
+
+// a socket connected to path, -1 if nothing listens there
+static int connectTo(const std::string& path) {
+    sockaddr_un addr;
+    if (!fillAddress(path, addr))
+        return -1;
+
+    const int FD = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (FD < 0)
+        return -1;
+
+    if (connect(FD, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(FD);
+        return -1;
+    }
+
+    return FD;
+}
+
+static bool writeAll(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.length()) {
+        // a client that went away must not take the daemon down with a SIGPIPE
+        const auto RET = send(fd, data.data() + written, data.length() - written, MSG_NOSIGNAL);
+        if (RET < 0 && errno == EINTR)
+            continue;
+        if (RET <= 0)
+            return false;
+        written += RET;
+    }
+
+    return true;
+}
+
+int NDaemon::listen(const std::string& path) {
+    sockaddr_un addr;
+    if (!fillAddress(path, addr)) {
+        Debug::log(ERR, "Invalid socket path %s", path.c_str());
+        return -1;
+    }
+
+    if (const int OTHER = connectTo(path); OTHER >= 0) {
+        close(OTHER);
+        Debug::log(ERR, "Another hyprpicker daemon is already listening on %s", path.c_str());
+        return -1;
+    }
+
+    // nobody answers, so whatever is there was left behind by a daemon that died
+    unlink(path.c_str());
+
+    const int FD = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (FD < 0) {
+        Debug::log(ERR, "Couldn't create a socket: %s", strerror(errno));
+        return -1;
+    }
+
+    if (bind(FD, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(FD, 4) < 0) {
+        Debug::log(ERR, "Couldn't listen on %s: %s", path.c_str(), strerror(errno));
+        close(FD);
+        return -1;
+    }
+
+    return FD;
+}
+
+int NDaemon::accept(int listenFD) {
+    return accept4(listenFD, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+}
+
+bool NDaemon::readRequest(int fd) {
+    // the request is tiny and written in one go right after connecting, so it arrives whole
+    char       buf[16];
+    const auto LEN = recv(fd, buf, sizeof(buf), 0);
+
+    return LEN == (ssize_t)strlen(REQUEST_PICK) && memcmp(buf, REQUEST_PICK, LEN) == 0;
+}
+
+bool NDaemon::connected(int fd) {
+    // clients send nothing after their request, stray bytes are dropped and only the end of the stream counts
+    char       buf[16];
+    const auto LEN = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+    return LEN > 0 || (LEN < 0 && (errno == EAGAIN || errno == EINTR));
+}
+
+void NDaemon::reply(int fd, int code, const std::string& output) {
+    if (!writeAll(fd, std::to_string(code) + "\n" + output))
+        Debug::log(TRACE, "The client left before getting its result");
+
+    close(fd);
+}
+
+bool NDaemon::trigger(const std::string& path, int& code, std::string& output) {
+    const int FD = connectTo(path);
+    if (FD < 0)
+        return false;
+
+    if (!writeAll(FD, REQUEST_PICK)) {
+        close(FD);
+        return false;
+    }
+
+    std::string response;
+    char        buf[4096];
+    while (true) {
+        const auto LEN = read(FD, buf, sizeof(buf));
+        if (LEN < 0 && errno == EINTR)
+            continue;
+        if (LEN <= 0)
+            break;
+        response.append(buf, LEN);
+    }
+
+    close(FD);
+
+    // the daemon closing without a status line means it died mid-session
+    const auto NEWLINE = response.find('\n');
+    if (NEWLINE == std::string::npos)
+        return false;
+
+    const auto [ptr, ec] = std::from_chars(response.data(), response.data() + NEWLINE, code);
+    if (ec != std::errc{} || ptr != response.data() + NEWLINE)
+        return false;
+
+    output = response.substr(NEWLINE + 1);
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+// --daemon / --trigger: a picker kept running with its wayland connection, and the clients asking it for picks.
+// A client connects to the socket and sends "pick\n". The daemon answers once the session is over with the exit code on the
+// first line and everything a normal run would have printed after it, then closes the connection.
+namespace NDaemon {
+    // $XDG_RUNTIME_DIR/hyprpicker-$WAYLAND_DISPLAY.sock, empty if XDG_RUNTIME_DIR isn't set
+    std::string socketPath();
+
+    // a non-blocking listening socket at path, replacing a stale one. -1 if that fails or another daemon already listens there
+    int         listen(const std::string& path);
+
+    // the next client on a listening socket, -1 if there is none
+    int         accept(int listenFD);
+    // true once a client asked for a pick, false for anything else or if it's gone
+    bool        readRequest(int fd);
+    // false once a client that already sent its request hung up
+    bool        connected(int fd);
+    // sends a session's result and closes the connection
+    void        reply(int fd, int code, const std::string& output);
+
+    // asks the daemon at path for a pick and waits for its answer. false if no daemon answered, otherwise code and output are its result
+    bool        trigger(const std::string& path, int& code, std::string& output);
+};
@@ -1,11 +1,12 @@
 #include "Log.hpp"
 
-#include <fstream>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <print>
 
-#include "../includes.hpp"
-
 void Debug::log(LogLevel level, const char* fmt, ...) {
     std::string levelstr = "";
 
@@ -0,0 +1,155 @@
+#include "Stats.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <ctime>
+#include <format>
+#include <fstream>
+#include <map>
+
+// values below 16 µs get a bucket each, above that every power of two is split into 16, up to 2^32 µs
+constexpr size_t SUBBUCKETS = 16;
+constexpr size_t BUCKETS    = (32 - 3) * SUBBUCKETS;
+
+struct SHistogram {
+    std::array<uint32_t, BUCKETS> buckets = {};
+    uint64_t                      count   = 0;
+    uint64_t                      sum     = 0;
+    uint64_t                      min     = UINT64_MAX;
+    uint64_t                      max     = 0;
+
+    void                          add(uint64_t us) {
+        buckets[bucket(us)]++;
+        count++;
+        sum += us;
+        min = std::min(min, us);
+        max = std::max(max, us);
+    }
+
+    void merge(const SHistogram& other) {
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+
+    // the middle of the bucket holding the sample at p, kept within what was actually seen
+    uint64_t percentile(double p) const {
+        const uint64_t RANK = std::max<uint64_t>(1, std::ceil(p * count));
+
+        uint64_t       seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i];
+            if (seen >= RANK)
+                return std::clamp(middle(i), min, max);
+        }
+
+        return max;
+    }
+
+    static size_t bucket(uint64_t us) {
+        us = std::min<uint64_t>(us, UINT32_MAX);
+        if (us < SUBBUCKETS)
+            return us;
+
+        const int EXP = std::bit_width(us) - 1;
+        return (EXP - 3) * SUBBUCKETS + ((us >> (EXP - 4)) & (SUBBUCKETS - 1));
+    }
+
+    static uint64_t middle(size_t bucket) {
+        if (bucket < SUBBUCKETS)
+            return bucket;
+
+        const int      EXP   = bucket / SUBBUCKETS + 3;
+        const uint64_t WIDTH = 1ULL << (EXP - 4);
+        return (SUBBUCKETS + bucket % SUBBUCKETS) * WIDTH + WIDTH / 2;
+    }
+};
+
+static constexpr std::array<const char*, Stats::STAGE_COUNT> STAGENAMES = {
+    "connect", "registry", "keymap", "capture_buffer", "capture_ready", "convert", "render", "background", "lens", "ring", "labels", "present", "first_frame", "live",
+};
+
+// per stage, per monitor ("" for stages that don't belong to one)
+static std::array<std::map<std::string, SHistogram>, Stats::STAGE_COUNT> histograms;
+
+uint64_t Stats::now() {
+    if (!enabled)
+        return 0;
+
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void Stats::record(eStage stage, const std::string& monitor, uint64_t since) {
+    if (!enabled || since == 0)
+        return;
+
+    histograms[stage][monitor].add(now() - since);
+}
+
+static std::string escape(const std::string& str) {
+    std::string out;
+    for (const char c : str) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+
+        if ((unsigned char)c < 0x20)
+            out += std::format("\\u{:04x}", c);
+        else
+            out += c;
+    }
+    return out;
+}
+
+static std::string summary(const SHistogram& h) {
+    return std::format(R"("count": {}, "mean_us": {}, "p50_us": {}, "p95_us": {}, "p99_us": {}, "max_us": {})", h.count, h.sum / h.count, h.percentile(0.5),
+                       h.percentile(0.95), h.percentile(0.99), h.max);
+}
+
+bool Stats::write(const std::string& path) {
+    std::string json = "{\n  \"stages\": {";
+    bool        first = true;
+
+    for (size_t stage = 0; stage < STAGE_COUNT; ++stage) {
+        if (histograms[stage].empty())
+            continue;
+
+        SHistogram all;
+        for (const auto& [monitor, h] : histograms[stage]) {
+            all.merge(h);
+        }
+
+        json += std::format("{}\n    \"{}\": {{{}", first ? "" : ",", STAGENAMES[stage], summary(all));
+        first = false;
+
+        // stages that happen once per session have no monitor
+        if (histograms[stage].size() == 1 && histograms[stage].contains(""))
+            json += "}";
+        else {
+            json += ", \"monitors\": {";
+            bool firstMonitor = true;
+            for (const auto& [monitor, h] : histograms[stage]) {
+                json += std::format("{}\n      \"{}\": {{{}}}", firstMonitor ? "" : ",", escape(monitor), summary(h));
+                firstMonitor = false;
+            }
+            json += "\n    }}";
+        }
+    }
+
+    json += "\n  }\n}\n";
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.good())
+        return false;
+
+    file << json;
+    file.close();
+    return file.good();
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// How long the stages of a pick session take, for --stats. Only ever recorded from the main thread.
+// Samples go into log-linear histograms (16 buckets per power of two), so a long session costs no more memory than a short one.
+namespace Stats {
+    enum eStage : uint8_t {
+        STAGE_CONNECT = 0,
+        // the first roundtrip, binding every global
+        STAGE_REGISTRY,
+        STAGE_KEYMAP,
+        // screencopy request -> buffer event
+        STAGE_CAPTURE_BUFFER,
+        // buffer event -> ready event, the compositor copying the frame
+        STAGE_CAPTURE_READY,
+        // format and transform conversion of the captured pixels
+        STAGE_CONVERT,
+        // one whole renderSurface, and the parts of it below
+        STAGE_RENDER,
+        STAGE_BACKGROUND,
+        // magnified pixels, their grid and the centre outline, which are drawn in one pass
+        STAGE_LENS,
+        STAGE_RING,
+        STAGE_LABELS,
+        // commit -> frame done
+        STAGE_PRESENT,
+        // start of the session -> first commit, per monitor
+        STAGE_FIRST_FRAME,
+        // --live: re-capture requested -> written into the screen buffer
+        STAGE_LIVE,
+        STAGE_COUNT,
+    };
+
+    inline bool enabled = false;
+
+    // monotonic microseconds, 0 while disabled so an unused timer costs a branch
+    uint64_t    now();
+    // records now() - since for a stage, on a monitor or on none (""). Ignores since == 0.
+    void        record(eStage stage, const std::string& monitor, uint64_t since);
+    // writes p50 / p95 / p99 of every stage that has samples, overall and per monitor, as JSON. False on failure.
+    bool        write(const std::string& path);
+
+    // records from construction to destruction
+    class CTimer {
+      public:
+        CTimer(eStage stage, const std::string& monitor = "") : m_stage(stage), m_monitor(monitor), m_start(now()) {}
+        ~CTimer() {
+            record(m_stage, m_monitor, m_start);
+        }
+
+      private:
+        eStage             m_stage;
+        std::string        m_monitor;
+        uint64_t           m_start;
+    };
+};
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "debug/Log.hpp"
+#include "debug/Stats.hpp"
 #include "includes.hpp"
 #include "helpers/Monitor.hpp"
 #include "helpers/Color.hpp"
+#include "helpers/Overlay.hpp"
 #include "clipboard/Clipboard.hpp"
 #include "notify/Notify.hpp"
 
@@ -27,25 +29,25 @@
 using namespace Hyprutils::Math;
 
 // UI/Zoom constants
-constexpr double ZOOM_TOGGLE_FACTOR = 3.0;
-constexpr double ZOOM_MAG_MIN       = 2.0;
-constexpr double ZOOM_MAG_MAX       = 60.0;
-constexpr double ZOOM_RADIUS_MIN    = 4.0;
-constexpr double ZOOM_RADIUS_MAX    = 60.0;
+constexpr double ZOOM_RADIUS_DEFAULT = 10.0; // source pixels
+constexpr double ZOOM_MAG_DEFAULT    = 10.0; // UI pixels per source pixel
+constexpr double ZOOM_TOGGLE_FACTOR  = 3.0;
+constexpr double ZOOM_MAG_MIN        = 2.0;
+constexpr double ZOOM_MAG_MAX        = 60.0;
+constexpr double ZOOM_RADIUS_MIN     = 4.0;
+constexpr double ZOOM_RADIUS_MAX     = 60.0;
+
+// Area sampling (--sample-radius, Ctrl-scroll), in screen buffer pixels
+constexpr int    SAMPLE_RADIUS_MAX = 32;
+// smooth scrolling units per radius step, about one wheel notch
+constexpr double SAMPLE_SCROLL_STEP = 10.0;
+
+// --watch: samples per second, and samples averaged by --smooth (a second's worth at the highest rate)
+constexpr double WATCH_RATE_MAX   = 1000.0;
+constexpr int    WATCH_SMOOTH_MAX = 1000;
 
 // Critically-damped spring parameters
 constexpr double SPRING_K    = 1000.0; // stiffness
 constexpr double SPRING_ZETA = 1.0;    // damping ratio
-
-// Ring and grid styling (in UI pixels, converted per-scale)
-constexpr double RING_OFFSET_UI_PX   = 5.0;
-constexpr double RING_BORDER_PX      = 2.0;
-constexpr double RING_SHADOW_PX      = 4.0;
-constexpr double RING_SHADOW_ALPHA   = 0.25;
-constexpr double GRID_ALPHA          = 0.12;
-
-// Preview label stacking
-constexpr double LABEL_STACK_SPACING_UI_PX = 22.0; // vertical spacing between stacked labels
-constexpr double LABEL_STACK_MARGIN_UI_PX  = 2.0;  // extra gap between labels
-constexpr double LABEL_HEIGHT_UI_PX        = 28.0; // bubble height (keep in sync with draw)
-constexpr double LABEL_ANIM_SPEED          = 12.0; // larger = faster approach to target (1/s)
+// Longest step the springs take at once. Idle surfaces don't render, so the first frame after a pause would otherwise see a huge dt
+constexpr double SPRING_MAX_DT = 1.0 / 60.0;
@@ -0,0 +1,168 @@
+#include "AreaSample.hpp"
+#include "ScreenBuffer.hpp"
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+CSummedAreaTable::CSummedAreaTable(CScreenBuffer& buffer, CWorkerPool* pool) : m_width(buffer.pixelSize.x), m_height(buffer.pixelSize.y) {
+    buffer.ensureAll(pool);
+
+    const size_t ROWSTRIDE = (m_width + 1) * 4;
+    m_sums.resize(ROWSTRIDE * (m_height + 1), 0);
+
+    // running sums along each row, rows are independent
+    const auto ROWS = [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            const auto SRC    = (const uint8_t*)buffer.data + (y * buffer.stride);
+            uint32_t*  dst    = m_sums.data() + ((y + 1) * ROWSTRIDE) + 4;
+            uint32_t   acc[4] = {0, 0, 0, 0};
+            for (size_t x = 0; x < m_width; ++x) {
+                for (size_t c = 0; c < 4; ++c) {
+                    acc[c] += SRC[x * 4 + c];
+                    dst[x * 4 + c] = acc[c];
+                }
+            }
+        }
+    };
+
+    // then down each column, in bands of columns so every pass reads and writes whole cache lines
+    const auto COLUMNS = [&](size_t begin, size_t end) {
+        for (size_t y = 2; y <= m_height; ++y) {
+            const uint32_t* above = m_sums.data() + ((y - 1) * ROWSTRIDE);
+            uint32_t*       row   = m_sums.data() + (y * ROWSTRIDE);
+            for (size_t i = begin * 4; i < end * 4; ++i) {
+                row[i] += above[i];
+            }
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(m_height, 16, ROWS);
+        pool->parallelFor(m_width + 1, 256, COLUMNS);
+    } else {
+        ROWS(0, m_height);
+        COLUMNS(0, m_width + 1);
+    }
+}
+
+void CSummedAreaTable::sum(int x0, int y0, int x1, int y1, uint64_t out[4]) const {
+    const size_t    ROWSTRIDE = (m_width + 1) * 4;
+    const uint32_t* top       = m_sums.data() + ((size_t)y0 * ROWSTRIDE);
+    const uint32_t* bottom    = m_sums.data() + ((size_t)y1 * ROWSTRIDE);
+
+    for (size_t c = 0; c < 4; ++c) {
+        // unsigned arithmetic undoes the wrap-around
+        out[c] = bottom[x1 * 4 + c] - bottom[x0 * 4 + c] - top[x1 * 4 + c] + top[x0 * 4 + c];
+    }
+}
+
+// B, G, R, A sums of a rect clipped to the buffer, from table or the pixels. Returns the number of pixels summed.
+static uint64_t sumRect(CScreenBuffer& buffer, const CSummedAreaTable* table, int x0, int y0, int x1, int y1, uint64_t out[4]) {
+    x0 = std::clamp(x0, 0, (int)buffer.pixelSize.x);
+    x1 = std::clamp(x1, 0, (int)buffer.pixelSize.x);
+    y0 = std::clamp(y0, 0, (int)buffer.pixelSize.y);
+    y1 = std::clamp(y1, 0, (int)buffer.pixelSize.y);
+
+    if (x0 >= x1 || y0 >= y1)
+        return 0;
+
+    if (table) {
+        uint64_t part[4];
+        table->sum(x0, y0, x1, y1, part);
+        for (size_t c = 0; c < 4; ++c) {
+            out[c] += part[c];
+        }
+    } else {
+        buffer.ensureRect(x0, y0, x1 - x0, y1 - y0);
+        for (int y = y0; y < y1; ++y) {
+            const auto ROW = (const uint8_t*)buffer.data + ((size_t)y * buffer.stride);
+            for (int x = x0; x < x1; ++x) {
+                for (size_t c = 0; c < 4; ++c) {
+                    out[c] += ROW[x * 4 + c];
+                }
+            }
+        }
+    }
+
+    return (uint64_t)(x1 - x0) * (y1 - y0);
+}
+
+// the half width of the circle's row dy away from the center. r^2 + r instead of r^2 keeps single pixels from poking out at the tips.
+static int circleHalfWidth(int radius, int dy) {
+    return (int)std::sqrt((double)(radius * radius + radius - dy * dy));
+}
+
+static CColor median(CScreenBuffer& buffer, int x0, int y0, int x1, int y1) {
+    x0 = std::clamp(x0, 0, (int)buffer.pixelSize.x);
+    x1 = std::clamp(x1, 0, (int)buffer.pixelSize.x);
+    y0 = std::clamp(y0, 0, (int)buffer.pixelSize.y);
+    y1 = std::clamp(y1, 0, (int)buffer.pixelSize.y);
+
+    if (x0 >= x1 || y0 >= y1)
+        return CColor{};
+
+    buffer.ensureRect(x0, y0, x1 - x0, y1 - y0);
+
+    // a histogram per channel, so the cost is one pass over the pixels and one over the bins, whatever the values
+    uint32_t histogram[4][256] = {};
+    for (int y = y0; y < y1; ++y) {
+        const auto ROW = (const uint8_t*)buffer.data + ((size_t)y * buffer.stride);
+        for (int x = x0; x < x1; ++x) {
+            for (size_t c = 0; c < 4; ++c) {
+                histogram[c][ROW[x * 4 + c]]++;
+            }
+        }
+    }
+
+    const uint32_t HALF = ((uint32_t)(x1 - x0) * (y1 - y0) + 1) / 2;
+    uint8_t        result[4];
+    for (size_t c = 0; c < 4; ++c) {
+        uint32_t seen = 0;
+        size_t   bin  = 0;
+        while (bin < 255 && (seen += histogram[c][bin]) < HALF) {
+            bin++;
+        }
+        result[c] = bin;
+    }
+
+    return CColor{.r = result[2], .g = result[1], .b = result[0], .a = result[3]};
+}
+
+CColor NSample::sample(CScreenBuffer& buffer, const CSummedAreaTable* table, eSampleMode mode, int x, int y, int radius) {
+    radius = std::max(radius, 0);
+
+    if (mode == SAMPLE_MEDIAN)
+        return median(buffer, x - radius, y - radius, x + radius + 1, y + radius + 1);
+
+    uint64_t sum[4] = {0, 0, 0, 0};
+    uint64_t count  = 0;
+
+    if (mode == SAMPLE_CIRCLE) {
+        // one rect per row, O(r) with a table
+        for (int dy = -radius; dy <= radius; ++dy) {
+            const int HALFWIDTH = circleHalfWidth(radius, dy);
+            count += sumRect(buffer, table, x - HALFWIDTH, y + dy, x + HALFWIDTH + 1, y + dy + 1, sum);
+        }
+    } else
+        count = sumRect(buffer, table, x - radius, y - radius, x + radius + 1, y + radius + 1, sum);
+
+    if (count == 0)
+        return CColor{};
+
+    const auto AVG = [&](size_t c) { return (uint8_t)((sum[c] + count / 2) / count); };
+
+    return CColor{.r = AVG(2), .g = AVG(1), .b = AVG(0), .a = AVG(3)};
+}
+
+std::string NSample::describe(eSampleMode mode, int radius) {
+    if (radius <= 0)
+        return "";
+
+    switch (mode) {
+        case SAMPLE_CIRCLE: return std::format("r{}", radius);
+        case SAMPLE_MEDIAN: return std::format("med {0}x{0}", 2 * radius + 1);
+        default: return std::format("{0}x{0}", 2 * radius + 1);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Color.hpp"
+
+class CScreenBuffer;
+class CWorkerPool;
+
+enum eSampleMode : uint8_t {
+    SAMPLE_BOX = 0, // the average of the (2r + 1) x (2r + 1) square around the pixel
+    SAMPLE_CIRCLE,  // the average of the pixels within r of it
+    SAMPLE_MEDIAN,  // the per-channel median of the square
+};
+
+// Per-channel sums of any rect of a screen buffer in O(1), from a table built once per capture.
+// The sums are 32 bits and wrap around on large buffers, differences of them are still exact for rects under 16M pixels.
+class CSummedAreaTable {
+  public:
+    // converts whatever is left of buffer first. Rows and then columns are split over the pool when one is given.
+    CSummedAreaTable(CScreenBuffer& buffer, CWorkerPool* pool = nullptr);
+
+    // B, G, R, A sums of [x0, x1) x [y0, y1), which has to lie inside the buffer
+    void                  sum(int x0, int y0, int x1, int y1, uint64_t out[4]) const;
+
+  private:
+    size_t                m_width = 0, m_height = 0;
+    // (width + 1) x (height + 1) entries of 4 channels, the first row and column are zero
+    std::vector<uint32_t> m_sums;
+};
+
+namespace NSample {
+    // the color picked at x, y (in buffer pixels) with radius r, the pixel itself for r = 0.
+    // Averages come from table when given, straight from the pixels otherwise. Pixels outside of the buffer don't count.
+    CColor      sample(CScreenBuffer& buffer, const CSummedAreaTable* table, eSampleMode mode, int x, int y, int radius);
+
+    // e.g. "5x5", "r2" or "med 5x5", empty for a single pixel
+    std::string describe(eSampleMode mode, int radius);
+};
@@ -1,6 +1,7 @@
 #include "Color.hpp"
 #include <algorithm>
-#include "../hyprpicker.hpp"
+#include <cmath>
+#include <limits>
 
 static float fmax3(float a, float b, float c) {
     return (a > b && a > c) ? a : (b > c) ? b : c;
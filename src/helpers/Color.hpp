@@ -1,6 +1,6 @@
 #pragma once
 
-#include "../defines.hpp"
+#include <cstdint>
 
 class CColor {
   public:
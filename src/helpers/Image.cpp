@@ -0,0 +1,254 @@
+#include "Image.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <wayland-client.h>
+#include <jpeglib.h>
+
+CImage::CImage(const std::string& path) {
+    const int FD = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (FD < 0) {
+        m_error = std::format("Couldn't open {}: {}", path, strerror(errno));
+        return;
+    }
+
+    struct stat st;
+    if (fstat(FD, &st) != 0 || st.st_size <= 0) {
+        m_error = std::format("Couldn't read {}", path);
+        close(FD);
+        return;
+    }
+
+    // private and writable: converting in place must never reach the file
+    m_mapSize  = st.st_size;
+    void* MAP = mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, FD, 0);
+    close(FD);
+
+    if (MAP == MAP_FAILED) {
+        m_error = std::format("Couldn't map {}: {}", path, strerror(errno));
+        m_mapSize = 0;
+        return;
+    }
+
+    m_map = (uint8_t*)MAP;
+
+    bool loaded = false;
+    if (m_mapSize >= 2 && m_map[0] == 'P' && (m_map[1] == '6' || m_map[1] == '7'))
+        loaded = loadPNM(m_map, m_mapSize);
+    else if (m_mapSize >= 8 && memcmp(m_map, "farbfeld", 8) == 0)
+        loaded = loadFarbfeld(m_map, m_mapSize);
+    else if (m_mapSize >= 2 && m_map[0] == 0xFF && m_map[1] == 0xD8)
+        loaded = loadJPEG(m_map, m_mapSize);
+    else
+        m_error = std::format("{} is not a binary PPM, PAM, farbfeld or JPEG image", path);
+
+    if (!loaded)
+        data = nullptr;
+
+    // decoded formats don't need the file anymore
+    if (!m_decoded.empty()) {
+        munmap(m_map, m_mapSize);
+        m_map     = nullptr;
+        m_mapSize = 0;
+    }
+}
+
+CImage::~CImage() {
+    if (m_map)
+        munmap(m_map, m_mapSize);
+}
+
+bool CImage::good() const {
+    return data && size.x > 0 && size.y > 0;
+}
+
+const std::string& CImage::error() const {
+    return m_error;
+}
+
+// next whitespace separated token of a PNM header, comments skipped. Leaves pos on the character after it.
+static std::string_view headerToken(const uint8_t* file, size_t fileSize, size_t& pos) {
+    while (pos < fileSize) {
+        if (file[pos] == '#') {
+            while (pos < fileSize && file[pos] != '\n') {
+                pos++;
+            }
+        } else if (isspace(file[pos]))
+            pos++;
+        else
+            break;
+    }
+
+    const size_t START = pos;
+    while (pos < fileSize && !isspace(file[pos])) {
+        pos++;
+    }
+
+    return {(const char*)file + START, pos - START};
+}
+
+static uint32_t headerNumber(const uint8_t* file, size_t fileSize, size_t& pos) {
+    const auto TOKEN = headerToken(file, fileSize, pos);
+
+    uint32_t   value = 0;
+    for (const char c : TOKEN) {
+        if (c < '0' || c > '9' || value > 1000000)
+            return 0;
+        value = value * 10 + (c - '0');
+    }
+
+    return value;
+}
+
+bool CImage::loadPNM(const uint8_t* file, size_t fileSize) {
+    size_t   pos   = 2;
+    uint32_t width = 0, height = 0, depth = 3, maxval = 0;
+
+    if (file[1] == '6') {
+        width  = headerNumber(file, fileSize, pos);
+        height = headerNumber(file, fileSize, pos);
+        maxval = headerNumber(file, fileSize, pos);
+    } else {
+        depth = 0;
+        while (pos < fileSize) {
+            const auto KEY = headerToken(file, fileSize, pos);
+            if (KEY == "ENDHDR")
+                break;
+            else if (KEY == "WIDTH")
+                width = headerNumber(file, fileSize, pos);
+            else if (KEY == "HEIGHT")
+                height = headerNumber(file, fileSize, pos);
+            else if (KEY == "DEPTH")
+                depth = headerNumber(file, fileSize, pos);
+            else if (KEY == "MAXVAL")
+                maxval = headerNumber(file, fileSize, pos);
+            else if (KEY == "TUPLTYPE")
+                headerToken(file, fileSize, pos);
+            else {
+                m_error = std::format("Unknown PAM header field {}", KEY);
+                return false;
+            }
+        }
+    }
+
+    // exactly one whitespace character separates the header from the pixels
+    pos++;
+
+    if (width == 0 || height == 0 || maxval != 255 || (depth != 3 && depth != 4)) {
+        m_error = std::format("Only 8-bit RGB and RGBA PPM / PAM images are supported (got {}x{}, depth {}, maxval {})", width, height, depth, maxval);
+        return false;
+    }
+
+    // R, G, B(, A) in memory is what wl_shm calls BGR888 and ABGR8888
+    stride = width * depth;
+    format = depth == 3 ? WL_SHM_FORMAT_BGR888 : WL_SHM_FORMAT_ABGR8888;
+    size   = {(double)width, (double)height};
+
+    if (pos > fileSize || fileSize - pos < (size_t)stride * height) {
+        m_error = "The image is truncated";
+        return false;
+    }
+
+    data = (void*)(file + pos);
+    return true;
+}
+
+bool CImage::loadFarbfeld(const uint8_t* file, size_t fileSize) {
+    const auto BE32 = [file](size_t at) { return (uint32_t)file[at] << 24 | (uint32_t)file[at + 1] << 16 | (uint32_t)file[at + 2] << 8 | file[at + 3]; };
+
+    if (fileSize < 16) {
+        m_error = "The image is truncated";
+        return false;
+    }
+
+    const uint32_t WIDTH = BE32(8), HEIGHT = BE32(12);
+    const size_t   PIXELS = (size_t)WIDTH * HEIGHT;
+
+    if (WIDTH == 0 || HEIGHT == 0 || (fileSize - 16) / 8 < PIXELS) {
+        m_error = "The image is truncated";
+        return false;
+    }
+
+    // 16-bit big endian RGBA to 8-bit R, G, B, A in memory, rounding to nearest
+    m_decoded.resize(PIXELS * 4);
+    const uint8_t* SRC = file + 16;
+    for (size_t i = 0; i < PIXELS * 4; ++i) {
+        const uint32_t V = (uint32_t)SRC[i * 2] << 8 | SRC[i * 2 + 1];
+        m_decoded[i]     = (V * 255 + 32767) / 65535;
+    }
+
+    stride = WIDTH * 4;
+    format = WL_SHM_FORMAT_ABGR8888;
+    size   = {(double)WIDTH, (double)HEIGHT};
+    data   = m_decoded.data();
+    return true;
+}
+
+struct SJPEGError {
+    jpeg_error_mgr mgr;
+    jmp_buf        jump;
+    char           message[JMSG_LENGTH_MAX];
+};
+
+static void onJPEGError(j_common_ptr info) {
+    const auto ERROR = (SJPEGError*)info->err;
+    info->err->format_message(info, ERROR->message);
+
+    longjmp(ERROR->jump, 1);
+}
+
+bool CImage::loadJPEG(const uint8_t* file, size_t fileSize) {
+    jpeg_decompress_struct info;
+    SJPEGError             error;
+
+    info.err               = jpeg_std_error(&error.mgr);
+    error.mgr.error_exit   = onJPEGError;
+
+    if (setjmp(error.jump)) {
+        m_error = std::format("Couldn't decode the JPEG: {}", error.message);
+        jpeg_destroy_decompress(&info);
+        m_decoded.clear();
+        return false;
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, file, fileSize);
+    jpeg_read_header(&info, TRUE);
+
+#ifdef JCS_EXTENSIONS
+    // libjpeg-turbo writes B, G, R, X straight away, which needs no conversion at all
+    info.out_color_space = JCS_EXT_BGRX;
+    const uint32_t BPP   = 4;
+    format               = WL_SHM_FORMAT_XRGB8888;
+#else
+    info.out_color_space = JCS_RGB;
+    const uint32_t BPP   = 3;
+    format               = WL_SHM_FORMAT_BGR888;
+#endif
+
+    jpeg_start_decompress(&info);
+
+    stride = info.output_width * BPP;
+    size   = {(double)info.output_width, (double)info.output_height};
+    m_decoded.resize((size_t)stride * info.output_height);
+
+    while (info.output_scanline < info.output_height) {
+        JSAMPROW row = m_decoded.data() + (size_t)info.output_scanline * stride;
+        jpeg_read_scanlines(&info, &row, 1);
+    }
+
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+
+    data = m_decoded.data();
+    return true;
+}
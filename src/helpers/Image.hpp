@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <hyprutils/math/Vector2D.hpp>
+using namespace Hyprutils::Math;
+
+// An image file standing in for a screencopy frame, for CFrame::fromFile. The pixels are in a wl_shm format, so CScreenBuffer converts them
+// exactly like a capture. Binary PPM and 8-bit PAM are used straight from a private mapping of the file (which CScreenBuffer may
+// convert in place), farbfeld is reduced to 8 bits per channel and JPEG is decoded.
+class CImage {
+  public:
+    CImage(const std::string& path);
+    ~CImage();
+
+    // false if the file couldn't be read or isn't a supported image, error() says why
+    bool               good() const;
+    const std::string& error() const;
+
+    void*    data = nullptr;
+    Vector2D size;
+    uint32_t stride = 0;
+    uint32_t format = 0;
+
+  private:
+    bool                 loadPNM(const uint8_t* file, size_t fileSize);
+    bool                 loadFarbfeld(const uint8_t* file, size_t fileSize);
+    bool                 loadJPEG(const uint8_t* file, size_t fileSize);
+
+    uint8_t*             m_map     = nullptr;
+    size_t               m_mapSize = 0;
+    std::vector<uint8_t> m_decoded;
+    std::string          m_error;
+};
@@ -3,6 +3,12 @@
 #include "../hyprpicker.hpp"
 
 CLayerSurface::CLayerSurface(SMonitor* pMonitor) : m_pMonitor(pMonitor) {
+    swapchain.name      = pMonitor->name;
+    swapchain.onRelease = [this]() {
+        if (renderPending && !frameCallback)
+            g_pHyprpicker->renderSurface(this);
+    };
+
     pSurface = makeShared<CCWlSurface>(g_pHyprpicker->m_pCompositor->sendCreateSurface());
 
     if (!pSurface) {
@@ -11,9 +17,10 @@ CLayerSurface::CLayerSurface(SMonitor* pMonitor) : m_pMonitor(pMonitor) {
         return;
     }
 
-    if (!g_pHyprpicker->m_bNoFractional) {
+    if (!g_pHyprpicker->m_bNoFractional || g_pHyprpicker->m_bSubsurface)
         pViewport = makeShared<CCWpViewport>(g_pHyprpicker->m_pViewporter->sendGetViewport(pSurface->resource()));
 
+    if (!g_pHyprpicker->m_bNoFractional) {
         // this will not actually be used, as we assume we'll be fullscreen and we can get the real dimensions from screencopy, but we'll have
         // this for if we need it in the future
         pFractionalScale = makeShared<CCWpFractionalScaleV1>(g_pHyprpicker->m_pFractionalMgr->sendGetFractionalScale(pSurface->resource()));
@@ -25,6 +32,9 @@ CLayerSurface::CLayerSurface(SMonitor* pMonitor) : m_pMonitor(pMonitor) {
         });
     }
 
+    if (g_pHyprpicker->m_bSubsurface)
+        initLens();
+
     pLayerSurface = makeShared<CCZwlrLayerSurfaceV1>(
         g_pHyprpicker->m_pLayerShell->sendGetLayerSurface(pSurface->resource(), pMonitor->output->resource(), ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, "hyprpicker"));
 
@@ -54,6 +64,9 @@ CLayerSurface::CLayerSurface(SMonitor* pMonitor) : m_pMonitor(pMonitor) {
 }
 
 CLayerSurface::~CLayerSurface() {
+    pLensSubsurface.reset();
+    pLensViewport.reset();
+    pLensSurface.reset();
     pLayerSurface.reset();
     pSurface.reset();
     frameCallback.reset();
@@ -66,19 +79,38 @@ CLayerSurface::~CLayerSurface() {
 static void onCallbackDone(CLayerSurface* surf, uint32_t when) {
     surf->frameCallback.reset();
 
+    Stats::record(Stats::STAGE_PRESENT, surf->m_pMonitor->name, surf->frameRequestedAt);
+
+    g_pHyprpicker->tickAnimations(surf, when);
+
+    // nothing changed since the last frame, keep what's on screen and stop asking for callbacks
+    if (!surf->dirty)
+        return;
+
     g_pHyprpicker->renderSurface(surf);
 }
 
-void CLayerSurface::sendFrame() {
-    lastBuffer          = lastBuffer == 0 ? 1 : 0;
-    const auto& PBUFFER = buffers[lastBuffer];
-
+void CLayerSurface::sendFrame(const SP<SPoolBuffer>& buffer) {
     frameCallback = makeShared<CCWlCallback>(pSurface->sendFrame());
     frameCallback->setDone([this](CCWlCallback* r, uint32_t when) { onCallbackDone(this, when); });
+    frameRequestedAt = Stats::now();
 
-    pSurface->sendDamageBuffer(0, 0, 0xFFFF, 0xFFFF);
+    // damage against what's on screen: the old and new overlay if only the overlay moved, everything otherwise
+    if (buffer->content == BUFFER_CONTENT_NONE || buffer->content != committedContent || buffer->contentSerial != committedSerial)
+        pSurface->sendDamageBuffer(0, 0, 0xFFFF, 0xFFFF);
+    else {
+        CRegion damage;
+        damage.set(committedOverlay).add(buffer->contentOverlay);
+        for (const auto& r : damage.getRects()) {
+            pSurface->sendDamageBuffer(r.x1, r.y1, r.x2 - r.x1, r.y2 - r.y1);
+        }
+    }
 
-    pSurface->sendAttach(PBUFFER->buffer.get(), 0, 0);
+    committedContent = buffer->content;
+    committedSerial  = buffer->contentSerial;
+    committedOverlay.set(buffer->contentOverlay);
+
+    pSurface->sendAttach(buffer->buffer.get(), 0, 0);
     if (!g_pHyprpicker->m_bNoFractional) {
         pSurface->sendSetBufferScale(1);
         pViewport->sendSetDestination(m_pMonitor->size.x, m_pMonitor->size.y);
@@ -86,11 +118,262 @@ void CLayerSurface::sendFrame() {
         pSurface->sendSetBufferScale(m_pMonitor->scale);
 
     pSurface->sendCommit();
+
+    swapchain.submitted(buffer);
+
+    if (!rendered)
+        g_pHyprpicker->onFirstFrame(this);
 }
 
 void CLayerSurface::markDirty() {
+    dirty = true;
+
+    // a frame is already on its way, its callback picks this up
+    if (frameCallback)
+        return;
+
+    // nothing on screen yet to wait for a frame on, the first render commits directly
+    if (!rendered) {
+        if (screenBuffer)
+            g_pHyprpicker->renderSurface(this);
+        return;
+    }
+
     frameCallback = makeShared<CCWlCallback>(pSurface->sendFrame());
     frameCallback->setDone([this](CCWlCallback* r, uint32_t when) { onCallbackDone(this, when); });
+    frameRequestedAt = Stats::now();
+    pSurface->sendCommit();
+}
 
-    dirty = true;
+void CLayerSurface::convertScreenBuffer() {
+    if (screenBuffer->fullyConverted())
+        return;
+
+    Stats::CTimer timer(Stats::STAGE_CONVERT, m_pMonitor->name);
+    screenBuffer->ensureAll(g_pHyprpicker->m_pWorkerPool.get());
+}
+
+void CLayerSurface::releaseCapture() {
+    if (captureBuffer && screenBuffer && screenBuffer->fullyConverted() && !screenBuffer->inPlace())
+        captureBuffer.reset();
+}
+
+void CLayerSurface::initLens() {
+    pLensSurface    = makeShared<CCWlSurface>(g_pHyprpicker->m_pCompositor->sendCreateSurface());
+    pLensSubsurface = makeShared<CCWlSubsurface>(g_pHyprpicker->m_pSubcompositor->sendGetSubsurface(pLensSurface.get(), pSurface.get()));
+    pLensViewport   = makeShared<CCWpViewport>(g_pHyprpicker->m_pViewporter->sendGetViewport(pLensSurface->resource()));
+
+    // the pointer has to keep hitting the layer surface underneath
+    auto region = makeShared<CCWlRegion>(g_pHyprpicker->m_pCompositor->sendCreateRegion());
+    pLensSurface->sendSetInputRegion(region.get());
+    region.reset();
+
+    lensSwapchain.name      = m_pMonitor->name + " lens";
+    lensSwapchain.onRelease = swapchain.onRelease;
+
+    clearBuffer = makeShared<SPoolBuffer>(Vector2D{1, 1}, WL_SHM_FORMAT_ARGB8888, 4);
+    memset(clearBuffer->data, 0, 4);
+}
+
+NResample::SImage CLayerSurface::displayBackground(const Vector2D& size) {
+    convertScreenBuffer();
+    releaseCapture();
+
+    const NResample::SImage SCREEN = {.data = (uint8_t*)screenBuffer->data, .width = (uint32_t)screenBuffer->pixelSize.x, .height = (uint32_t)screenBuffer->pixelSize.y,
+                                      .stride = screenBuffer->stride};
+
+    if (screenBuffer->pixelSize == size)
+        return SCREEN;
+
+    const NResample::SImage SCALED = {.data = nullptr, .width = (uint32_t)size.x, .height = (uint32_t)size.y, .stride = (uint32_t)size.x * 4};
+
+    if (displayBackgroundData.empty() || displayBackgroundSize != size || displayBackgroundSerial != screenBufferSerial) {
+        displayBackgroundData.resize((size_t)SCALED.stride * SCALED.height);
+        displayBackgroundSize   = size;
+        displayBackgroundSerial = screenBufferSerial;
+
+        NResample::area(SCREEN, {.data = displayBackgroundData.data(), .width = SCALED.width, .height = SCALED.height, .stride = SCALED.stride},
+                        g_pHyprpicker->m_pWorkerPool.get());
+
+        Debug::log(TRACE, "displayBackground: resampled %.0fx%.0f to %.0fx%.0f", screenBuffer->pixelSize.x, screenBuffer->pixelSize.y, size.x, size.y);
+    }
+
+    return {.data = displayBackgroundData.data(), .width = SCALED.width, .height = SCALED.height, .stride = SCALED.stride};
+}
+
+bool CLayerSurface::ensureBackground() {
+    if (backgroundBuffer && backgroundSerial == screenBufferSerial)
+        return true;
+
+    backgroundBuffer.reset();
+
+    if (!screenBuffer)
+        return false;
+
+    backgroundSerial = screenBufferSerial;
+
+    convertScreenBuffer();
+
+    // a NORMAL xrgb / argb capture was converted in place and already is what we'd attach
+    if (screenBuffer->inPlace() && captureBuffer && (screenBufferFormat == WL_SHM_FORMAT_XRGB8888 || screenBufferFormat == WL_SHM_FORMAT_ARGB8888)) {
+        backgroundBuffer = captureBuffer;
+        return true;
+    }
+
+    const auto SIZE  = screenBuffer->pixelSize;
+    backgroundBuffer = makeShared<SPoolBuffer>(SIZE, WL_SHM_FORMAT_XRGB8888, SIZE.x * 4);
+
+    const auto SRC    = (const uint8_t*)screenBuffer->data;
+    const auto DST    = (uint8_t*)backgroundBuffer->data;
+    const auto STRIDE = screenBuffer->stride;
+    g_pHyprpicker->m_pWorkerPool->parallelFor(SIZE.y, 64, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            memcpy(DST + y * backgroundBuffer->stride, SRC + y * STRIDE, SIZE.x * 4);
+        }
+    });
+
+    releaseCapture();
+
+    return true;
+}
+
+void CLayerSurface::setBackground(bool frozen) {
+    if (frozen && !ensureBackground())
+        frozen = false;
+
+    const auto CONTENT = frozen ? BUFFER_CONTENT_FROZEN : BUFFER_CONTENT_CLEAR;
+    if (committedContent == CONTENT && committedSerial == screenBufferSerial)
+        return;
+
+    const auto& BUFFER = frozen ? backgroundBuffer : clearBuffer;
+    pSurface->sendAttach(BUFFER->buffer.get(), 0, 0);
+    pSurface->sendSetBufferScale(1);
+    BUFFER->busy = true;
+    pSurface->sendDamageBuffer(0, 0, 0xFFFF, 0xFFFF);
+
+    committedContent = CONTENT;
+    committedSerial  = screenBufferSerial;
+}
+
+void CLayerSurface::sendLens(const SP<SPoolBuffer>& buffer, const Vector2D& pos, const Vector2D& size) {
+    pLensSurface->sendAttach(buffer->buffer.get(), 0, 0);
+    pLensSurface->sendSetBufferScale(1);
+    pLensViewport->sendSetDestination(size.x, size.y);
+    pLensSurface->sendDamageBuffer(0, 0, 0xFFFF, 0xFFFF);
+    pLensSurface->sendCommit();
+
+    // applied together with the lens contents on the next commit of pSurface
+    pLensSubsurface->sendSetPosition(pos.x, pos.y);
+
+    lensSwapchain.submitted(buffer);
+    lensMapped = true;
+}
+
+void CLayerSurface::hideLens() {
+    if (!lensMapped)
+        return;
+
+    pLensSurface->sendAttach(nullptr, 0, 0);
+    pLensSurface->sendCommit();
+
+    lensMapped = false;
+}
+
+void CLayerSurface::commitFrame() {
+    frameCallback = makeShared<CCWlCallback>(pSurface->sendFrame());
+    frameCallback->setDone([this](CCWlCallback* r, uint32_t when) { onCallbackDone(this, when); });
+    frameRequestedAt = Stats::now();
+
+    pViewport->sendSetDestination(m_pMonitor->size.x, m_pMonitor->size.y);
+
+    pSurface->sendCommit();
+
+    if (!rendered)
+        g_pHyprpicker->onFirstFrame(this);
+}
+
+// a separate function because liveFrame.reset() destroys the screencopy frame whose ready listener calls this, only surf is used after
+static void onLiveFrameReady(CLayerSurface* surf) {
+    surf->liveFrame.reset();
+    surf->applyLiveFrame();
+
+    // rendering the lens asks for the next capture
+    g_pHyprpicker->markDirty(surf);
+}
+
+void CLayerSurface::requestLiveFrame(const CBox& around) {
+    // captures are written over converted pixels, so nothing may be converted from the first capture after this
+    convertScreenBuffer();
+
+    const auto   MANAGER = g_pHyprpicker->m_pScreencopyMgr;
+    const double SCALE   = screenBuffer->pixelSize.x / m_pMonitor->size.x;
+
+    liveBox    = around;
+    liveRegion = false;
+
+    // a region is in logical pixels, it only covers whole screenBuffer pixels at an integer scale
+    if (std::abs(SCALE - std::round(SCALE)) < 0.001 && std::abs(screenBuffer->pixelSize.y / m_pMonitor->size.y - SCALE) < 0.001) {
+        const double S  = std::round(SCALE);
+        const double X0 = std::clamp(std::floor(around.x / S), 0.0, m_pMonitor->size.x), Y0 = std::clamp(std::floor(around.y / S), 0.0, m_pMonitor->size.y);
+        const double X1 = std::clamp(std::ceil((around.x + around.w) / S), 0.0, m_pMonitor->size.x);
+        const double Y1 = std::clamp(std::ceil((around.y + around.h) / S), 0.0, m_pMonitor->size.y);
+
+        if (X1 > X0 && Y1 > Y0) {
+            liveBox    = CBox{X0, Y0, X1 - X0, Y1 - Y0}.scale(S);
+            liveRegion = true;
+            liveFrame = makeShared<CCZwlrScreencopyFrameV1>(MANAGER->sendCaptureOutputRegion(false, m_pMonitor->output->resource(), X0, Y0, X1 - X0, Y1 - Y0));
+        }
+    }
+
+    if (!liveFrame)
+        liveFrame = makeShared<CCZwlrScreencopyFrameV1>(MANAGER->sendCaptureOutput(false, m_pMonitor->output->resource()));
+
+    liveRequestedAt = Stats::now();
+
+    liveFrame->setBuffer([this](CCZwlrScreencopyFrameV1* r, uint32_t format, uint32_t width, uint32_t height, uint32_t stride) {
+        if (!liveBuffer || liveBuffer->pixelSize != Vector2D{(double)width, (double)height} || liveBuffer->format != format || liveBuffer->stride != stride)
+            liveBuffer = makeShared<SPoolBuffer>(Vector2D{(double)width, (double)height}, format, stride);
+
+        // with damage the compositor holds the frame until the screen changes, without it the frame callbacks pace the captures
+        if (g_pHyprpicker->m_iScreencopyVersion >= 2)
+            liveFrame->sendCopyWithDamage(liveBuffer->buffer->resource());
+        else
+            liveFrame->sendCopy(liveBuffer->buffer->resource());
+    });
+    liveFrame->setReady([this](CCZwlrScreencopyFrameV1* r, uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec) { onLiveFrameReady(this); });
+    liveFrame->setFailed([this](CCZwlrScreencopyFrameV1* r) {
+        Debug::log(TRACE, "A live capture of %s failed", m_pMonitor->name.c_str());
+        liveFrame.reset();
+    });
+}
+
+void CLayerSurface::applyLiveFrame() {
+    if (!liveBuffer || !screenBuffer)
+        return;
+
+    const NPixelConvert::SFrame SOURCE = {.data   = (const uint8_t*)liveBuffer->data,
+                                          .width  = (uint32_t)liveBuffer->pixelSize.x,
+                                          .height = (uint32_t)liveBuffer->pixelSize.y,
+                                          .stride = liveBuffer->stride,
+                                          .format = liveBuffer->format};
+    const auto                  TRANSFORM = m_pMonitor->transform;
+    const auto                  UPRIGHT   = TRANSFORM % 2 == 1 ? Vector2D{liveBuffer->pixelSize.y, liveBuffer->pixelSize.x} : liveBuffer->pixelSize;
+
+    if (liveRegion) {
+        // the compositor rounds regions on its own, a capture that doesn't match the box exactly can't be placed
+        if (UPRIGHT != liveBox.size()) {
+            Debug::log(TRACE, "Dropping a live capture of %.0fx%.0f for a %.0fx%.0f box", UPRIGHT.x, UPRIGHT.y, liveBox.w, liveBox.h);
+            return;
+        }
+
+        // the region is small, all of it is converted
+        NPixelConvert::convertFrame(SOURCE, (uint8_t*)screenBuffer->data + ((size_t)liveBox.y * screenBuffer->stride) + ((size_t)liveBox.x * 4), screenBuffer->stride,
+                                    TRANSFORM);
+        cairo_surface_mark_dirty_rectangle(screenBuffer->surface, liveBox.x, liveBox.y, liveBox.w, liveBox.h);
+    } else
+        screenBuffer->refreshRect(SOURCE, liveBox.x, liveBox.y, liveBox.w, liveBox.h);
+
+    sampleTable.reset();
+
+    Stats::record(Stats::STAGE_LIVE, m_pMonitor->name, liveRequestedAt);
 }
@@ -1,7 +1,11 @@
 #pragma once
 
 #include "../defines.hpp"
+#include "AreaSample.hpp"
 #include "PoolBuffer.hpp"
+#include "Resample.hpp"
+#include "ScreenBuffer.hpp"
+#include "Swapchain.hpp"
 
 struct SMonitor;
 
@@ -10,8 +14,27 @@ class CLayerSurface {
     CLayerSurface(SMonitor*);
     ~CLayerSurface();
 
-    void                      sendFrame();
+    // attaches and commits a buffer from the swapchain
+    void                      sendFrame(const SP<SPoolBuffer>& buffer);
     void                      markDirty();
+    // converts whatever is left of screenBuffer on the worker pool
+    void                      convertScreenBuffer();
+    // drops the screencopy buffer once screenBuffer doesn't read from it anymore
+    void                      releaseCapture();
+    // the frozen screen at size buffer pixels: screenBuffer itself if it already has that size, otherwise a cached area-filtered copy
+    NResample::SImage         displayBackground(const Vector2D& size);
+
+    // --subsurface: the frozen screen (or nothing) on pSurface, stretched by its viewport. Only attaches when that changes.
+    void                      setBackground(bool frozen);
+    // --subsurface: shows buffer in the lens subsurface at a logical position and size, or unmaps it
+    void                      sendLens(const SP<SPoolBuffer>& buffer, const Vector2D& pos, const Vector2D& size);
+    void                      hideLens();
+    // --subsurface: requests a frame and commits pSurface, which applies the lens state with it
+    void                      commitFrame();
+    // --live: captures a box of screenBuffer pixels around the lens again, or the whole output if a region can't line up with
+    // screenBuffer's pixels, and writes the box into screenBuffer once it lands
+    void                      requestLiveFrame(const CBox& around);
+    void                      applyLiveFrame();
 
     SMonitor*                 m_pMonitor = nullptr;
 
@@ -26,16 +49,63 @@ class CLayerSurface {
     uint32_t                  ACKSerial       = 0;
     bool                      working         = false;
 
-    int                       lastBuffer = 0;
-    SP<SPoolBuffer>           buffers[2];
+    CSwapchain                swapchain;
+    // buffer pixels covering the whole surface
+    Vector2D                  canvasSize;
+    // a render was dropped because every buffer was busy, render again on the next release
+    bool                      renderPending = false;
 
-    SP<SPoolBuffer>           screenBuffer;
+    // screencopy target, kept while screenBuffer still has tiles to convert from it (or converts in place)
+    SP<SPoolBuffer>           captureBuffer;
+    SP<CScreenBuffer>         screenBuffer;
+    // bumped whenever screenBuffer is replaced, buffers holding an older one have to be repainted
+    uint32_t                  screenBufferSerial = 0;
     uint32_t                  scflags            = 0;
     uint32_t                  screenBufferFormat = 0;
 
+    // built from screenBuffer the first time an area is averaged on it, dropped whenever its pixels change
+    std::unique_ptr<CSummedAreaTable> sampleTable;
+
+    // backs displayBackground() when screenBuffer has a different size, rebuilt for a new screenBuffer or buffer size
+    std::vector<uint8_t>      displayBackgroundData;
+    Vector2D                  displayBackgroundSize;
+    uint32_t                  displayBackgroundSerial = 0;
+
     bool                      dirty = true;
 
     bool                      rendered = false;
 
+    // what the compositor shows right now, damage is sent against it
+    eBufferContent            committedContent = BUFFER_CONTENT_NONE;
+    uint32_t                  committedSerial  = 0;
+    CRegion                   committedOverlay;
+
     SP<CCWlCallback>          frameCallback = nullptr;
+    // Stats::now() at the commit frameCallback belongs to
+    uint64_t                  frameRequestedAt = 0;
+
+    // --subsurface: the lens, ring and labels live in a small synchronized subsurface on top of the frozen screen
+    SP<CCWlSurface>           pLensSurface;
+    SP<CCWlSubsurface>        pLensSubsurface;
+    SP<CCWpViewport>          pLensViewport;
+    CSwapchain                lensSwapchain;
+    bool                      lensMapped = false;
+    // the frozen screen as a wl_buffer, attached once
+    SP<SPoolBuffer>           backgroundBuffer;
+    uint32_t                  backgroundSerial = 0;
+    // 1x1 transparent, stretched over inactive surfaces
+    SP<SPoolBuffer>           clearBuffer;
+
+    // --live: the capture in flight, and the buffer it goes into, kept for as long as captures keep their size and format
+    SP<CCZwlrScreencopyFrameV1> liveFrame;
+    SP<SPoolBuffer>             liveBuffer;
+    // what the capture refreshes in screenBuffer (upright pixels). Only this box is taken from a whole output capture too,
+    // everywhere else it would contain our own overlay.
+    CBox                        liveBox;
+    bool                        liveRegion      = false;
+    uint64_t                    liveRequestedAt = 0;
+
+  private:
+    void                      initLens();
+    bool                      ensureBackground();
 };
\ No newline at end of file
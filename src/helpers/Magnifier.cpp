@@ -0,0 +1,224 @@
+#include "Magnifier.hpp"
+#include "PixelConvert.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HYPRPICKER_X86 1
+#include <immintrin.h>
+#endif
+
+// source index of every destination pixel in [first - 1, first + count), stepped in 16.16 fixed point.
+// The extra leading entry lets callers find a cell boundary on the first pixel too.
+static std::vector<int32_t> sourceIndices(double srcAt, double dstAt, int first, int count, double magnification) {
+    std::vector<int32_t> indices(count + 1);
+
+    const int64_t        STEP = std::llround(65536.0 / magnification);
+    int64_t              pos  = std::llround((srcAt + (first - 1 + 0.5 - dstAt) / magnification) * 65536.0);
+
+    for (auto& i : indices) {
+        i = (int32_t)(pos >> 16);
+        pos += STEP;
+    }
+
+    return indices;
+}
+
+// marks width pixels starting at every change of the source index
+static std::vector<uint8_t> cellBoundaries(const std::vector<int32_t>& indices, int width) {
+    std::vector<uint8_t> lines(indices.size() - 1, 0);
+
+    if (width <= 0)
+        return lines;
+
+    for (size_t i = 1; i < indices.size(); ++i) {
+        if (indices[i] == indices[i - 1])
+            continue;
+
+        for (size_t j = i - 1; j < std::min(lines.size(), i - 1 + width); ++j) {
+            lines[j] = 1;
+        }
+    }
+
+    return lines;
+}
+
+static void fillScalar(uint32_t* dst, uint32_t px, size_t count) {
+    std::fill_n(dst, count, px);
+}
+
+#ifdef HYPRPICKER_X86
+
+static void fillSSE2(uint32_t* dst, uint32_t px, size_t count) {
+    const __m128i PX = _mm_set1_epi32((int)px);
+
+    size_t        i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(dst + i), PX);
+    }
+
+    fillScalar(dst + i, px, count - i);
+}
+
+#endif
+
+// premultiplied white at alpha over px
+static inline uint32_t blendWhite(uint32_t px, uint32_t alpha) {
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const uint32_t C = (px >> shift) & 0xFF;
+        out |= (C + ((255 - C) * alpha + 127) / 255) << shift;
+    }
+    return out;
+}
+
+// src at coverage over dst
+static inline uint32_t blendCoverage(uint32_t src, uint32_t dst, uint32_t coverage) {
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const uint32_t S = (src >> shift) & 0xFF;
+        const uint32_t D = (dst >> shift) & 0xFF;
+        out |= ((S * coverage + D * (255 - coverage) + 127) / 255) << shift;
+    }
+    return out;
+}
+
+void NMagnifier::render(const NResample::SImage& src, const NResample::SImage& dst, const SLens& lens) {
+    if (!src.data || !dst.data || lens.radius <= 0 || lens.magnification <= 0)
+        return;
+
+    const double R  = lens.radius;
+    const double CX = lens.center.x, CY = lens.center.y;
+
+    const int    X0 = std::max(0, (int)std::floor(CX - R - 1)), X1 = std::min((int)dst.width, (int)std::ceil(CX + R + 1));
+    const int    Y0 = std::max(0, (int)std::floor(CY - R - 1)), Y1 = std::min((int)dst.height, (int)std::ceil(CY + R + 1));
+
+    if (X0 >= X1 || Y0 >= Y1)
+        return;
+
+    const int  W = X1 - X0, H = Y1 - Y0;
+
+    const auto COLS     = sourceIndices(lens.srcAt.x, lens.dstAt.x, X0, W, lens.magnification);
+    const auto ROWS     = sourceIndices(lens.srcAt.y, lens.dstAt.y, Y0, H, lens.magnification);
+    const auto GRIDCOLS = cellBoundaries(COLS, lens.gridWidth);
+    const auto GRIDROWS = cellBoundaries(ROWS, lens.gridWidth);
+
+    // the indices only grow, so the columns that land inside the source are one range [c0, c1)
+    int c0 = 0, c1 = W;
+    while (c0 < W && COLS[c0 + 1] < 0) {
+        c0++;
+    }
+    while (c1 > c0 && COLS[c1] >= (int32_t)src.width) {
+        c1--;
+    }
+
+    if (c0 >= c1)
+        return;
+
+    auto fill = fillScalar;
+#ifdef HYPRPICKER_X86
+    if (NPixelConvert::backend() >= NPixelConvert::BACKEND_SSE2)
+        fill = fillSSE2;
+#endif
+
+    // one replicated source row, as it looks off and on a horizontal grid line. Consecutive destination rows reuse it.
+    std::vector<uint32_t> plain(W), lined(W);
+    int32_t               cachedRow = INT_MIN;
+
+    const double          INNER = R - 0.5, OUTER = R + 0.5;
+
+    for (int y = Y0; y < Y1; ++y) {
+        const double DY = y + 0.5 - CY;
+        if (std::abs(DY) >= OUTER)
+            continue;
+
+        const int32_t SY = ROWS[y - Y0 + 1];
+        if (SY < 0 || SY >= (int32_t)src.height)
+            continue;
+
+        if (SY != cachedRow) {
+            const auto SRCROW = (const uint32_t*)(src.data + (size_t)SY * src.stride);
+
+            for (int x = c0; x < c1;) {
+                const int32_t SX  = COLS[x + 1];
+                int           end = x + 1;
+                while (end < c1 && COLS[end + 1] == SX) {
+                    end++;
+                }
+
+                fill(plain.data() + x, SRCROW[SX], end - x);
+                x = end;
+            }
+
+            for (int x = c0; x < c1; ++x) {
+                lined[x] = blendWhite(plain[x], lens.gridAlpha);
+                if (GRIDCOLS[x])
+                    plain[x] = lined[x];
+            }
+
+            cachedRow = SY;
+        }
+
+        const auto& ROW    = GRIDROWS[y - Y0] ? lined : plain;
+        const auto  DSTROW = (uint32_t*)(dst.data + (size_t)y * dst.stride);
+
+        // pixels whose centre is within INNER of the centre are fully covered, the ones up to OUTER get partial coverage
+        const double HO = std::sqrt(OUTER * OUTER - DY * DY);
+        const double HI = std::abs(DY) < INNER ? std::sqrt(INNER * INNER - DY * DY) : -1;
+
+        const int    O0 = std::max(X0 + c0, (int)std::ceil(CX - HO - 0.5)), O1 = std::min(X0 + c1 - 1, (int)std::floor(CX + HO - 0.5));
+        int          I0 = O1 + 1, I1 = O1;
+        if (HI >= 0) {
+            I0 = std::max(O0, (int)std::ceil(CX - HI - 0.5));
+            I1 = std::min(O1, (int)std::floor(CX + HI - 0.5));
+        }
+
+        if (I0 <= I1)
+            memcpy(DSTROW + I0, ROW.data() + (I0 - X0), (size_t)(I1 - I0 + 1) * 4);
+
+        for (int x = O0; x <= O1; ++x) {
+            if (x == I0 && I0 <= I1) {
+                x = I1;
+                continue;
+            }
+
+            const double DIST     = std::hypot(x + 0.5 - CX, DY);
+            const double COVERAGE = std::clamp(OUTER - DIST, 0.0, 1.0);
+            DSTROW[x]             = blendCoverage(ROW[x - X0], DSTROW[x], (uint32_t)std::lround(COVERAGE * 255));
+        }
+    }
+
+    if (lens.outlineWidth <= 0)
+        return;
+
+    // the centre cell in destination pixels, [l, r) x [t, b)
+    const auto CELLX = std::ranges::equal_range(COLS.begin() + 1, COLS.end(), (int32_t)lens.srcPixel.x);
+    const auto CELLY = std::ranges::equal_range(ROWS.begin() + 1, ROWS.end(), (int32_t)lens.srcPixel.y);
+    if (CELLX.empty() || CELLY.empty())
+        return;
+
+    const int L = X0 + (CELLX.begin() - COLS.begin() - 1), RT = X0 + (CELLX.end() - COLS.begin() - 1);
+    const int T = Y0 + (CELLY.begin() - ROWS.begin() - 1), B = Y0 + (CELLY.end() - ROWS.begin() - 1);
+
+    // straddles the cell's edges like a stroke would
+    const int  HALF = lens.outlineWidth / 2;
+
+    const auto RECT = [&](int x0, int y0, int x1, int y1) {
+        for (int y = std::max(y0, Y0); y < std::min(y1, Y1); ++y) {
+            const auto DSTROW = (uint32_t*)(dst.data + (size_t)y * dst.stride);
+            for (int x = std::max(x0, X0); x < std::min(x1, X1); ++x) {
+                if (std::hypot(x + 0.5 - CX, y + 0.5 - CY) <= R)
+                    DSTROW[x] = 0xFFFFFFFF;
+            }
+        }
+    };
+
+    RECT(L - HALF, T - HALF, RT - HALF + lens.outlineWidth, T - HALF + lens.outlineWidth);
+    RECT(L - HALF, B - HALF, RT - HALF + lens.outlineWidth, B - HALF + lens.outlineWidth);
+    RECT(L - HALF, T - HALF, L - HALF + lens.outlineWidth, B - HALF + lens.outlineWidth);
+    RECT(RT - HALF, T - HALF, RT - HALF + lens.outlineWidth, B - HALF + lens.outlineWidth);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <hyprutils/math/Vector2D.hpp>
+using namespace Hyprutils::Math;
+
+#include "Resample.hpp"
+
+// Rasterizes the zoom lens straight into ARGB32 memory: nearest-neighbour magnified source pixels inside a circle,
+// with the pixel grid and the outline of the centre cell drawn in the same pass.
+namespace NMagnifier {
+    struct SLens {
+        // circle, in destination pixels
+        Vector2D center;
+        double   radius = 0;
+
+        // destination pixels per source pixel, and one point that maps between the two: source = srcAt + (dst - dstAt) / magnification
+        double   magnification = 1;
+        Vector2D srcAt;
+        Vector2D dstAt;
+
+        // the source pixel whose cell gets the outline
+        Vector2D srcPixel;
+
+        // in destination pixels, 0 disables
+        int      gridWidth    = 1;
+        int      outlineWidth = 2;
+        // white over the source pixels on grid lines
+        uint8_t  gridAlpha = 0;
+    };
+
+    // Source pixels outside of src are left out, so whatever dst holds there stays visible. The circle's edge is antialiased against dst.
+    void render(const NResample::SImage& src, const NResample::SImage& dst, const SLens& lens);
+};
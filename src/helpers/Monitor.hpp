@@ -9,6 +9,7 @@ class CLayerSurface;
 struct SMonitor {
     SMonitor(SP<CCWlOutput> output_);
     void                        initSCFrame();
+    void                        initXDGOutput();
 
     std::string                 name         = "";
     SP<CCWlOutput>              output       = nullptr;
@@ -17,8 +18,16 @@ struct SMonitor {
     int                         scale;
     wl_output_transform         transform = WL_OUTPUT_TRANSFORM_NORMAL;
 
+    // position and size in the global logical space, only known after initXDGOutput()
+    Vector2D                    logicalPosition;
+    Vector2D                    logicalSize;
+    SP<CCZxdgOutputV1>          xdgOutput = nullptr;
+
     bool                        ready = false;
 
     CLayerSurface*              pLS      = nullptr;
     SP<CCZwlrScreencopyFrameV1> pSCFrame = nullptr;
+    // Stats::now() when pSCFrame was requested and when its buffer event came
+    uint64_t                    captureRequestedAt = 0;
+    uint64_t                    captureBufferAt    = 0;
 };
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "Overlay.hpp"
+#include "Magnifier.hpp"
+#include "TextAtlas.hpp"
+#include "../debug/Stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// a box covering [x, x + w) x [y, y + h) on whole pixels, with room for antialiasing
+static CBox damageBox(double x, double y, double w, double h) {
+    const double X1 = std::floor(x) - 2, Y1 = std::floor(y) - 2;
+    const double X2 = std::ceil(x + w) + 2, Y2 = std::ceil(y + h) + 2;
+    return {X1, Y1, X2 - X1, Y2 - Y1};
+}
+
+// a rounded label bubble, filled with the current source
+static void bubble(cairo_t* cr, double x, double y, double width, double height, double radius) {
+    cairo_move_to(cr, x + radius, y);
+    cairo_arc(cr, x + width - radius, y + radius, radius, -M_PI_2, 0);
+    cairo_arc(cr, x + width - radius, y + height - radius, radius, 0, M_PI_2);
+    cairo_arc(cr, x + radius, y + height - radius, radius, M_PI_2, M_PI);
+    cairo_arc(cr, x + radius, y + radius, radius, M_PI, -M_PI_2);
+    cairo_close_path(cr);
+    cairo_fill(cr);
+}
+
+double NOverlay::lensExtent(double radius, double onePx) {
+    // the ring's shadow is the outermost thing the lens draws
+    return radius + RING_OFFSET_UI_PX * onePx + (1.0 + RING_SHADOW_PX / 2.0) * onePx;
+}
+
+void NOverlay::draw(cairo_t* cr, const Vector2D& canvasSize, const NResample::SImage& src, const SState& state, CRegion& damage) {
+    const auto   CENTER        = state.center;
+    const double RADIUS        = state.radius;
+    const double ONEPX         = state.onePx;
+    const double OUTERRADIUS   = RADIUS + RING_OFFSET_UI_PX * ONEPX; // thin border ring
+    const double EXTENT        = lensExtent(RADIUS, ONEPX);
+
+    // we draw the preview like this
+    //
+    //     200px        ZOOM: 10x
+    // | --------- |
+    // |           |
+    // |     x     | 200px
+    // |           |
+    // | --------- |
+    //
+    // (hex code here)
+
+    cairo_save(cr);
+
+    cairo_set_source_rgba(cr, state.color.r / 255.f, state.color.g / 255.f, state.color.b / 255.f, state.color.a / 255.f);
+
+    damage.add(damageBox(CENTER.x - EXTENT, CENTER.y - EXTENT, 2 * EXTENT, 2 * EXTENT));
+    cairo_arc(cr, CENTER.x, CENTER.y, OUTERRADIUS, 0, 2 * M_PI);
+    cairo_clip(cr);
+
+    cairo_fill(cr);
+    cairo_paint(cr);
+
+    cairo_surface_flush(cairo_get_target(cr));
+
+    cairo_restore(cr);
+    cairo_save(cr);
+
+    // the magnified pixels, their grid and the centre-cell outline, in one pass over the target's memory
+    {
+        Stats::CTimer     timer(Stats::STAGE_LENS, state.monitor);
+
+        NMagnifier::SLens lens = {
+            .center        = CENTER,
+            .radius        = RADIUS,
+            .magnification = std::max(0.01, state.magnification),
+            .srcAt         = state.srcPixel + Vector2D{0.5, 0.5},
+            .dstAt         = state.srcPixel / state.srcPerCanvas + state.offset + Vector2D{0.5, 0.5},
+            .srcPixel      = state.srcPixel.floor(),
+            .gridWidth     = std::max(1, (int)std::round(ONEPX)),
+            .outlineWidth  = std::max(1, (int)std::round(2.0 * ONEPX)),
+            .gridAlpha     = (uint8_t)std::round(GRID_ALPHA * 255),
+        };
+
+        const auto TARGET = cairo_get_target(cr);
+
+        if (cairo_surface_get_type(TARGET) == CAIRO_SURFACE_TYPE_IMAGE) {
+            cairo_surface_flush(TARGET);
+            NMagnifier::render(src,
+                               {.data   = cairo_image_surface_get_data(TARGET),
+                                .width  = (uint32_t)cairo_image_surface_get_width(TARGET),
+                                .height = (uint32_t)cairo_image_surface_get_height(TARGET),
+                                .stride = (uint32_t)cairo_image_surface_get_stride(TARGET)},
+                               lens);
+            cairo_surface_mark_dirty(TARGET);
+        } else {
+            // --subsurface records the overlay, so the lens goes through a small image of its own
+            const Vector2D ORIGIN = (CENTER - Vector2D{RADIUS + 1, RADIUS + 1}).floor();
+            const int      SIZE   = std::ceil(2 * RADIUS + 3);
+            const auto     IMAGE  = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+
+            lens.center = lens.center - ORIGIN;
+            lens.dstAt  = lens.dstAt - ORIGIN;
+
+            cairo_surface_flush(IMAGE);
+            NMagnifier::render(src, {.data = cairo_image_surface_get_data(IMAGE), .width = (uint32_t)SIZE, .height = (uint32_t)SIZE, .stride = (uint32_t)cairo_image_surface_get_stride(IMAGE)},
+                               lens);
+            cairo_surface_mark_dirty(IMAGE);
+
+            cairo_set_source_surface(cr, IMAGE, ORIGIN.x, ORIGIN.y);
+            cairo_paint(cr);
+            cairo_surface_destroy(IMAGE);
+        }
+    }
+
+    // Draw ring border + shadow now (outside any clip) so labels can render on top
+    {
+        Stats::CTimer timer(Stats::STAGE_RING, state.monitor);
+
+        cairo_reset_clip(cr);
+        cairo_save(cr);
+        cairo_set_antialias(cr, CAIRO_ANTIALIAS_DEFAULT);
+        cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
+
+        // Shadow: soft halo outside the ring
+        cairo_set_source_rgba(cr, 0.0, 0.0, 0.0, RING_SHADOW_ALPHA);
+        cairo_set_line_width(cr, RING_SHADOW_PX * ONEPX);
+        cairo_new_path(cr);
+        cairo_arc(cr, CENTER.x, CENTER.y, OUTERRADIUS + 1.0 * ONEPX, 0, 2 * M_PI);
+        cairo_stroke(cr);
+
+        // White border: crisp 2px stroke around the ring
+        cairo_set_source_rgba(cr, 1.0, 1.0, 1.0, 1.0);
+        cairo_set_line_width(cr, RING_BORDER_PX * ONEPX);
+        cairo_new_path(cr);
+        cairo_arc(cr, CENTER.x, CENTER.y, OUTERRADIUS, 0, 2 * M_PI);
+        cairo_stroke(cr);
+
+        cairo_restore(cr);
+    }
+
+    if (!state.label.empty() && state.text) {
+        Stats::CTimer timer(Stats::STAGE_LABELS, state.monitor);
+
+        auto&         text   = *state.text;
+
+        const double  HEIGHT = LABEL_HEIGHT_UI_PX, CORNER = 6, PADDING = 5.0;
+        const double  TEXTWIDTH = text.measure(state.label);
+        const double  WIDTH     = TEXTWIDTH + 2 * PADDING;
+
+        // keep below the circle unless too close to the bottom, and shift left near the right edge
+        const bool    NEARRIGHT  = CENTER.x > canvasSize.x - 100;
+        const bool    PLACEABOVE = CENTER.y > canvasSize.y - 50;
+        const double  X          = (NEARRIGHT ? CENTER.x - 80 : CENTER.x) - TEXTWIDTH / 2;
+        const double  Y          = PLACEABOVE ? CENTER.y - 40 : CENTER.y + 20;
+        const double  TEXTY      = PLACEABOVE ? CENTER.y - 20 : CENTER.y + 40;
+
+        // Ensure labels are not clipped by the zoom circle
+        cairo_reset_clip(cr);
+
+        // Draw stacked labels first (duplicates), animating above/below
+        if (state.stack) {
+            for (const auto& item : *state.stack) {
+                const double OFFSET = item.offsetCurrentUI;
+                const double ITEMW  = text.measure(item.text) + 2 * PADDING;
+
+                cairo_set_source_rgba(cr, 0.0, 0.0, 0.0, 0.75);
+                bubble(cr, X, Y + OFFSET, ITEMW, HEIGHT, CORNER);
+
+                cairo_set_source_rgba(cr, 1.0, 1.0, 1.0, 1.0);
+                const auto TEXTBOX = text.draw(cr, item.text, X + PADDING, TEXTY + OFFSET);
+
+                damage.add(damageBox(X, Y + OFFSET, ITEMW, HEIGHT));
+                damage.add(damageBox(TEXTBOX.x, TEXTBOX.y, TEXTBOX.w, TEXTBOX.h));
+            }
+        }
+
+        // Draw the current top label
+        cairo_set_source_rgba(cr, 0.0, 0.0, 0.0, 0.75);
+        bubble(cr, X, Y, WIDTH, HEIGHT, CORNER);
+
+        cairo_set_source_rgba(cr, 1.0, 1.0, 1.0, 1.0);
+        const auto TEXTBOX = text.draw(cr, state.label, X + PADDING, TEXTY);
+
+        damage.add(damageBox(X, Y, WIDTH, HEIGHT));
+        damage.add(damageBox(TEXTBOX.x, TEXTBOX.y, TEXTBOX.w, TEXTBOX.h));
+
+        cairo_surface_flush(cairo_get_target(cr));
+    }
+
+    cairo_restore(cr);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cairo/cairo.h>
+#include <hyprutils/math/Region.hpp>
+#include <hyprutils/math/Vector2D.hpp>
+using namespace Hyprutils::Math;
+
+#include "Color.hpp"
+#include "Resample.hpp"
+
+class CTextAtlas;
+
+// Ring and grid styling (in UI pixels, converted per-scale)
+constexpr double RING_OFFSET_UI_PX   = 5.0;
+constexpr double RING_BORDER_PX      = 2.0;
+constexpr double RING_SHADOW_PX      = 4.0;
+constexpr double RING_SHADOW_ALPHA   = 0.25;
+constexpr double GRID_ALPHA          = 0.12;
+
+// Preview label stacking
+constexpr double LABEL_STACK_SPACING_UI_PX = 22.0; // vertical spacing between stacked labels
+constexpr double LABEL_STACK_MARGIN_UI_PX  = 2.0;  // extra gap between labels
+constexpr double LABEL_HEIGHT_UI_PX        = 28.0; // bubble height (keep in sync with draw)
+constexpr double LABEL_ANIM_SPEED          = 12.0; // larger = faster approach to target (1/s)
+
+// What hyprpicker draws around the pointer: the magnified pixels, the ring around them and the preview labels.
+// Takes the state of one frame and nothing of the picker, so the bench draws exactly the same thing.
+namespace NOverlay {
+    struct SStackedLabel {
+        std::string text;
+        double      offsetCurrentUI = 0.0; // animated vertical offset in UI pixels
+        double      offsetTargetUI  = 0.0; // target offset in UI pixels
+    };
+
+    struct SState {
+        // the picked pixel of the source, in its pixels, and source pixels per canvas pixel
+        Vector2D                          srcPixel;
+        Vector2D                          srcPerCanvas = {1, 1};
+        // the lens circle in canvas pixels, and how far it sits from the picked pixel's place on the canvas (--live moves it off the pointer)
+        Vector2D                          center;
+        Vector2D                          offset;
+        double                            radius        = 0;
+        // canvas pixels per source pixel
+        double                            magnification = 1;
+        // canvas pixels per UI pixel, the ring, grid and outline widths scale with it
+        double                            onePx = 1;
+        // fills the ring's gap, and whatever of the lens lies off the source
+        CColor                            color;
+        // the current label and the older ones stacked next to it, in text's font. No labels at all when label is empty.
+        std::string                       label;
+        CTextAtlas*                       text  = nullptr;
+        const std::vector<SStackedLabel>* stack = nullptr;
+        // for --stats
+        std::string                       monitor;
+    };
+
+    // distance from the lens center to the outer edge of the ring's shadow, in canvas pixels
+    double lensExtent(double radius, double onePx);
+
+    // Draws the overlay into cr, whose target covers the whole canvas at canvasSize pixels, and adds what it covers to damage.
+    // Image targets get the magnified pixels written straight into their memory, others (recordings) through a small image.
+    void   draw(cairo_t* cr, const Vector2D& canvasSize, const NResample::SImage& src, const SState& state, CRegion& damage);
+};
@@ -0,0 +1,428 @@
+#include "PixelConvert.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include <wayland-client.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HYPRPICKER_X86 1
+#include <immintrin.h>
+#endif
+
+// 10 -> 8 bit: round(v * 255 / 1023) == floor((v * 255 + 511) / 1023), and 255v / 1023 is never exactly .5 away from an integer.
+// The division is done as ((x + 1) * 1025) >> 20, which is exact for every x we can produce, so SIMD only needs shifts and adds.
+// 2 -> 8 bit alpha: round(a * 255 / 3) == a * 85.
+static inline uint32_t reduce10(uint32_t v) {
+    const uint32_t X = (v << 8) - v + 512;
+    return ((X << 10) + X) >> 20;
+}
+
+static void swapRBScalar(const uint32_t* src, uint32_t* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t PX = src[i];
+        dst[i]            = (PX & 0xFF00FF00) | ((PX >> 16) & 0xFF) | ((PX & 0xFF) << 16);
+    }
+}
+
+static void reduce2101010Scalar(const uint32_t* src, uint32_t* dst, size_t count, bool swapRB) {
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t PX = src[i];
+
+        const uint32_t LO = reduce10(PX & 0x3FF);
+        const uint32_t G  = reduce10((PX >> 10) & 0x3FF);
+        const uint32_t HI = reduce10((PX >> 20) & 0x3FF);
+        const uint32_t A  = (PX >> 30) * 85;
+
+        dst[i] = ((swapRB ? HI : LO) << 0) | (G << 8) | ((swapRB ? LO : HI) << 16) | (A << 24);
+    }
+}
+
+// these two keep the exact byte layout the original per-pixel loops produced
+static void expandBGR888Scalar(const uint8_t* src, uint32_t* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i, src += 3) {
+        dst[i] = (uint32_t)src[2] | ((uint32_t)src[1] << 8) | ((uint32_t)src[0] << 16) | 0xFF000000;
+    }
+}
+
+static void expandRGB888Scalar(const uint8_t* src, uint32_t* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i, src += 3) {
+        dst[i] = 0xFF | ((uint32_t)src[0] << 8) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 24);
+    }
+}
+
+#ifdef HYPRPICKER_X86
+
+static void swapRBSSE2(const uint32_t* src, uint32_t* dst, size_t count) {
+    const __m128i KEEP = _mm_set1_epi32((int)0xFF00FF00);
+    const __m128i LOW  = _mm_set1_epi32(0xFF);
+
+    size_t        i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i PX  = _mm_loadu_si128((const __m128i*)(src + i));
+        const __m128i OUT = _mm_or_si128(_mm_and_si128(PX, KEEP), _mm_or_si128(_mm_and_si128(_mm_srli_epi32(PX, 16), LOW), _mm_slli_epi32(_mm_and_si128(PX, LOW), 16)));
+        _mm_storeu_si128((__m128i*)(dst + i), OUT);
+    }
+
+    swapRBScalar(src + i, dst + i, count - i);
+}
+
+static inline __m128i reduce10SSE2(__m128i v) {
+    const __m128i X = _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(v, 8), v), _mm_set1_epi32(512));
+    return _mm_srli_epi32(_mm_add_epi32(_mm_slli_epi32(X, 10), X), 20);
+}
+
+static void reduce2101010SSE2(const uint32_t* src, uint32_t* dst, size_t count, bool swapRB) {
+    const __m128i MASK10 = _mm_set1_epi32(0x3FF);
+
+    size_t        i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i PX = _mm_loadu_si128((const __m128i*)(src + i));
+
+        const __m128i LO = reduce10SSE2(_mm_and_si128(PX, MASK10));
+        const __m128i G  = reduce10SSE2(_mm_and_si128(_mm_srli_epi32(PX, 10), MASK10));
+        const __m128i HI = reduce10SSE2(_mm_and_si128(_mm_srli_epi32(PX, 20), MASK10));
+        const __m128i A2 = _mm_srli_epi32(PX, 30);
+        // a * 85 == a | a << 2 | a << 4 | a << 6 for a 2-bit a
+        const __m128i A = _mm_or_si128(_mm_or_si128(A2, _mm_slli_epi32(A2, 2)), _mm_or_si128(_mm_slli_epi32(A2, 4), _mm_slli_epi32(A2, 6)));
+
+        __m128i       out = _mm_or_si128(_mm_slli_epi32(G, 8), _mm_slli_epi32(A, 24));
+        out               = _mm_or_si128(out, swapRB ? _mm_or_si128(HI, _mm_slli_epi32(LO, 16)) : _mm_or_si128(LO, _mm_slli_epi32(HI, 16)));
+        _mm_storeu_si128((__m128i*)(dst + i), out);
+    }
+
+    reduce2101010Scalar(src + i, dst + i, count - i, swapRB);
+}
+
+__attribute__((target("ssse3"))) static void swapRBSSSE3(const uint32_t* src, uint32_t* dst, size_t count) {
+    const __m128i SHUF = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    size_t        i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + i)), SHUF));
+    }
+
+    swapRBScalar(src + i, dst + i, count - i);
+}
+
+// 4 packed pixels are 12 bytes, but we load 16, so the loop stops while at least 16 source bytes remain
+__attribute__((target("ssse3"))) static void expandBGR888SSSE3(const uint8_t* src, uint32_t* dst, size_t count) {
+    const __m128i SHUF  = _mm_setr_epi8(2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+    const __m128i ALPHA = _mm_set1_epi32((int)0xFF000000);
+
+    size_t        i = 0;
+    for (; i + 6 <= count; i += 4) {
+        const __m128i PX = _mm_loadu_si128((const __m128i*)(src + i * 3));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_shuffle_epi8(PX, SHUF), ALPHA));
+    }
+
+    expandBGR888Scalar(src + i * 3, dst + i, count - i);
+}
+
+__attribute__((target("ssse3"))) static void expandRGB888SSSE3(const uint8_t* src, uint32_t* dst, size_t count) {
+    const __m128i SHUF  = _mm_setr_epi8(-128, 0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11);
+    const __m128i ALPHA = _mm_set1_epi32(0xFF);
+
+    size_t        i = 0;
+    for (; i + 6 <= count; i += 4) {
+        const __m128i PX = _mm_loadu_si128((const __m128i*)(src + i * 3));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_shuffle_epi8(PX, SHUF), ALPHA));
+    }
+
+    expandRGB888Scalar(src + i * 3, dst + i, count - i);
+}
+
+__attribute__((target("avx2"))) static void swapRBAVX2(const uint32_t* src, uint32_t* dst, size_t count) {
+    const __m256i SHUF = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    size_t        i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + i)), SHUF));
+    }
+
+    swapRBSSSE3(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx2"))) static inline __m256i reduce10AVX2(__m256i v) {
+    const __m256i X = _mm256_add_epi32(_mm256_sub_epi32(_mm256_slli_epi32(v, 8), v), _mm256_set1_epi32(512));
+    return _mm256_srli_epi32(_mm256_add_epi32(_mm256_slli_epi32(X, 10), X), 20);
+}
+
+__attribute__((target("avx2"))) static void reduce2101010AVX2(const uint32_t* src, uint32_t* dst, size_t count, bool swapRB) {
+    const __m256i MASK10 = _mm256_set1_epi32(0x3FF);
+
+    size_t        i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i PX = _mm256_loadu_si256((const __m256i*)(src + i));
+
+        const __m256i LO = reduce10AVX2(_mm256_and_si256(PX, MASK10));
+        const __m256i G  = reduce10AVX2(_mm256_and_si256(_mm256_srli_epi32(PX, 10), MASK10));
+        const __m256i HI = reduce10AVX2(_mm256_and_si256(_mm256_srli_epi32(PX, 20), MASK10));
+        const __m256i A2 = _mm256_srli_epi32(PX, 30);
+        const __m256i A  = _mm256_or_si256(_mm256_or_si256(A2, _mm256_slli_epi32(A2, 2)), _mm256_or_si256(_mm256_slli_epi32(A2, 4), _mm256_slli_epi32(A2, 6)));
+
+        __m256i       out = _mm256_or_si256(_mm256_slli_epi32(G, 8), _mm256_slli_epi32(A, 24));
+        out = _mm256_or_si256(out, swapRB ? _mm256_or_si256(HI, _mm256_slli_epi32(LO, 16)) : _mm256_or_si256(LO, _mm256_slli_epi32(HI, 16)));
+        _mm256_storeu_si256((__m256i*)(dst + i), out);
+    }
+
+    reduce2101010SSE2(src + i, dst + i, count - i, swapRB);
+}
+
+// vpshufb works within 128-bit lanes, so each lane gets its own 12-byte group of 4 pixels
+__attribute__((target("avx2"))) static void expandBGR888AVX2(const uint8_t* src, uint32_t* dst, size_t count) {
+    const __m256i SHUF  = _mm256_setr_epi8(2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128, 2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+    const __m256i ALPHA = _mm256_set1_epi32((int)0xFF000000);
+
+    size_t        i = 0;
+    for (; i + 10 <= count; i += 8) {
+        const __m256i PX = _mm256_loadu2_m128i((const __m128i*)(src + i * 3 + 12), (const __m128i*)(src + i * 3));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(_mm256_shuffle_epi8(PX, SHUF), ALPHA));
+    }
+
+    expandBGR888SSSE3(src + i * 3, dst + i, count - i);
+}
+
+__attribute__((target("avx2"))) static void expandRGB888AVX2(const uint8_t* src, uint32_t* dst, size_t count) {
+    const __m256i SHUF  = _mm256_setr_epi8(-128, 0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128, 0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11);
+    const __m256i ALPHA = _mm256_set1_epi32(0xFF);
+
+    size_t        i = 0;
+    for (; i + 10 <= count; i += 8) {
+        const __m256i PX = _mm256_loadu2_m128i((const __m128i*)(src + i * 3 + 12), (const __m128i*)(src + i * 3));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(_mm256_shuffle_epi8(PX, SHUF), ALPHA));
+    }
+
+    expandRGB888SSSE3(src + i * 3, dst + i, count - i);
+}
+
+#endif
+
+struct SKernels {
+    void (*swapRB)(const uint32_t*, uint32_t*, size_t)              = swapRBScalar;
+    void (*reduce2101010)(const uint32_t*, uint32_t*, size_t, bool) = reduce2101010Scalar;
+    void (*expandBGR888)(const uint8_t*, uint32_t*, size_t)         = expandBGR888Scalar;
+    void (*expandRGB888)(const uint8_t*, uint32_t*, size_t)         = expandRGB888Scalar;
+};
+
+static bool cpuSupports(NPixelConvert::eBackend backend) {
+    switch (backend) {
+        case NPixelConvert::BACKEND_SCALAR: return true;
+#ifdef HYPRPICKER_X86
+        case NPixelConvert::BACKEND_SSE2: return __builtin_cpu_supports("sse2");
+        case NPixelConvert::BACKEND_SSSE3: return __builtin_cpu_supports("ssse3");
+        case NPixelConvert::BACKEND_AVX2: return __builtin_cpu_supports("avx2");
+#endif
+        default: return false;
+    }
+}
+
+static SKernels kernelsFor(NPixelConvert::eBackend backend) {
+    SKernels k;
+
+#ifdef HYPRPICKER_X86
+    if (backend >= NPixelConvert::BACKEND_SSE2) {
+        k.swapRB        = swapRBSSE2;
+        k.reduce2101010 = reduce2101010SSE2;
+    }
+
+    if (backend >= NPixelConvert::BACKEND_SSSE3) {
+        k.swapRB       = swapRBSSSE3;
+        k.expandBGR888 = expandBGR888SSSE3;
+        k.expandRGB888 = expandRGB888SSSE3;
+    }
+
+    if (backend >= NPixelConvert::BACKEND_AVX2) {
+        k.swapRB        = swapRBAVX2;
+        k.reduce2101010 = reduce2101010AVX2;
+        k.expandBGR888  = expandBGR888AVX2;
+        k.expandRGB888  = expandRGB888AVX2;
+    }
+#endif
+
+    return k;
+}
+
+static NPixelConvert::eBackend bestBackend() {
+    for (auto b : {NPixelConvert::BACKEND_AVX2, NPixelConvert::BACKEND_SSSE3, NPixelConvert::BACKEND_SSE2}) {
+        if (cpuSupports(b))
+            return b;
+    }
+
+    return NPixelConvert::BACKEND_SCALAR;
+}
+
+// every backend's table is built during static initialisation and never changes. setBackend only swaps which one g_kernels
+// points at, so threads converting at the time finish their row with the old kernels, which give the same bytes.
+static const SKernels                        g_tables[] = {kernelsFor(NPixelConvert::BACKEND_SCALAR), kernelsFor(NPixelConvert::BACKEND_SSE2),
+                                                           kernelsFor(NPixelConvert::BACKEND_SSSE3), kernelsFor(NPixelConvert::BACKEND_AVX2)};
+static std::atomic<NPixelConvert::eBackend> g_backend = bestBackend();
+static std::atomic<const SKernels*>          g_kernels = &g_tables[g_backend];
+
+NPixelConvert::eBackend NPixelConvert::backend() {
+    return g_backend;
+}
+
+bool NPixelConvert::setBackend(eBackend backend) {
+    if (!cpuSupports(backend))
+        return false;
+
+    g_kernels = &g_tables[backend];
+    g_backend = backend;
+    return true;
+}
+
+const char* NPixelConvert::backendName(eBackend backend) {
+    switch (backend) {
+        case BACKEND_SCALAR: return "scalar";
+        case BACKEND_SSE2: return "sse2";
+        case BACKEND_SSSE3: return "ssse3";
+        case BACKEND_AVX2: return "avx2";
+    }
+
+    return "unknown";
+}
+
+void NPixelConvert::swapRB(const uint32_t* src, uint32_t* dst, size_t count) {
+    g_kernels.load(std::memory_order_relaxed)->swapRB(src, dst, count);
+}
+
+void NPixelConvert::reduce2101010(const uint32_t* src, uint32_t* dst, size_t count, bool swapRB) {
+    g_kernels.load(std::memory_order_relaxed)->reduce2101010(src, dst, count, swapRB);
+}
+
+void NPixelConvert::expandBGR888(const uint8_t* src, uint32_t* dst, size_t count) {
+    g_kernels.load(std::memory_order_relaxed)->expandBGR888(src, dst, count);
+}
+
+void NPixelConvert::expandRGB888(const uint8_t* src, uint32_t* dst, size_t count) {
+    g_kernels.load(std::memory_order_relaxed)->expandRGB888(src, dst, count);
+}
+
+uint32_t NPixelConvert::bytesPerPixel(uint32_t format) {
+    switch (format) {
+        case WL_SHM_FORMAT_ARGB8888:
+        case WL_SHM_FORMAT_XRGB8888:
+        case WL_SHM_FORMAT_ABGR8888:
+        case WL_SHM_FORMAT_XBGR8888:
+        case WL_SHM_FORMAT_XRGB2101010:
+        case WL_SHM_FORMAT_XBGR2101010: return 4;
+        case WL_SHM_FORMAT_BGR888:
+        case WL_SHM_FORMAT_RGB888: return 3;
+        default: return 0;
+    }
+}
+
+void NPixelConvert::convertRow(const uint8_t* src, uint32_t* dst, size_t count, uint32_t format) {
+    switch (format) {
+        case WL_SHM_FORMAT_ARGB8888:
+        case WL_SHM_FORMAT_XRGB8888:
+            if ((const void*)src != (const void*)dst)
+                memcpy(dst, src, count * 4);
+            break;
+        case WL_SHM_FORMAT_ABGR8888:
+        case WL_SHM_FORMAT_XBGR8888: swapRB((const uint32_t*)src, dst, count); break;
+        case WL_SHM_FORMAT_XRGB2101010:
+        case WL_SHM_FORMAT_XBGR2101010: reduce2101010((const uint32_t*)src, dst, count, format == WL_SHM_FORMAT_XBGR2101010); break;
+        case WL_SHM_FORMAT_BGR888: expandBGR888(src, dst, count); break;
+        case WL_SHM_FORMAT_RGB888: expandRGB888(src, dst, count); break;
+        default: break;
+    }
+}
+
+// Where source pixel (sx, sy) lands in the destination: origin + sx * stepX + sy * stepY, in pixels.
+// 90/180/270 match the cairo rotation we used to paint with, the flipped variants mirror x before rotating (as wlroots does).
+struct SMapping {
+    ptrdiff_t origin = 0, stepX = 1, stepY = 0;
+};
+
+static SMapping mappingFor(uint32_t transform, ptrdiff_t W, ptrdiff_t H, ptrdiff_t S) {
+    switch (transform) {
+        case WL_OUTPUT_TRANSFORM_90: return {H - 1, S, -1};
+        case WL_OUTPUT_TRANSFORM_180: return {(W - 1) + (H - 1) * S, -1, -S};
+        case WL_OUTPUT_TRANSFORM_270: return {(W - 1) * S, -S, 1};
+        case WL_OUTPUT_TRANSFORM_FLIPPED: return {W - 1, -1, S};
+        case WL_OUTPUT_TRANSFORM_FLIPPED_90: return {0, S, 1};
+        case WL_OUTPUT_TRANSFORM_FLIPPED_180: return {(H - 1) * S, 1, -S};
+        case WL_OUTPUT_TRANSFORM_FLIPPED_270: return {(H - 1) + (W - 1) * S, -S, -1};
+        default: return {0, 1, S};
+    }
+}
+
+// 64x64 ARGB32 is 16 KiB of scratch, which stays in L1 next to the source rows being read
+constexpr uint32_t TILE = 64;
+
+void NPixelConvert::convertRect(const SFrame& src, uint8_t* dst, uint32_t dstStride, uint32_t transform, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    const uint32_t BPP = bytesPerPixel(src.format);
+    if (!BPP)
+        return;
+
+    x1 = std::min(x1, src.width);
+    y1 = std::min(y1, src.height);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    const auto MAP = mappingFor(transform, src.width, src.height, dstStride / 4);
+    uint32_t*  out = (uint32_t*)dst;
+
+    const auto SRCPX = [&](uint32_t x, uint32_t y) { return src.data + ((size_t)y * src.stride) + ((size_t)x * BPP); };
+    const auto DSTPX = [&](uint32_t x, uint32_t y) { return out + MAP.origin + ((ptrdiff_t)x * MAP.stepX) + ((ptrdiff_t)y * MAP.stepY); };
+
+    if (MAP.stepX == 1) {
+        // rows stay rows, convert straight into the destination
+        for (uint32_t y = y0; y < y1; ++y) {
+            convertRow(SRCPX(x0, y), DSTPX(x0, y), x1 - x0, src.format);
+        }
+        return;
+    }
+
+    alignas(64) uint32_t scratch[TILE * TILE];
+
+    if (MAP.stepX == -1) {
+        // mirrored rows: convert a chunk into scratch, then write it back to front
+        for (uint32_t y = y0; y < y1; ++y) {
+            for (uint32_t x = x0; x < x1; x += TILE) {
+                const uint32_t N = std::min(TILE, x1 - x);
+                convertRow(SRCPX(x, y), scratch, N, src.format);
+
+                uint32_t* d = DSTPX(x, y);
+                for (uint32_t i = 0; i < N; ++i) {
+                    *(d - i) = scratch[i];
+                }
+            }
+        }
+        return;
+    }
+
+    // rotations: source rows become destination columns. Convert a tile of source rows into scratch,
+    // then emit it one source column at a time, which is one contiguous destination row run.
+    for (uint32_t ty = y0; ty < y1; ty += TILE) {
+        const uint32_t H = std::min(TILE, y1 - ty);
+
+        for (uint32_t tx = x0; tx < x1; tx += TILE) {
+            const uint32_t W = std::min(TILE, x1 - tx);
+
+            for (uint32_t r = 0; r < H; ++r) {
+                convertRow(SRCPX(tx, ty + r), scratch + (size_t)r * TILE, W, src.format);
+            }
+
+            for (uint32_t c = 0; c < W; ++c) {
+                uint32_t* d = DSTPX(tx + c, ty);
+                if (MAP.stepY == 1) {
+                    for (uint32_t r = 0; r < H; ++r) {
+                        d[r] = scratch[(size_t)r * TILE + c];
+                    }
+                } else {
+                    for (uint32_t r = 0; r < H; ++r) {
+                        *(d - r) = scratch[(size_t)r * TILE + c];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void NPixelConvert::convertFrame(const SFrame& src, uint8_t* dst, uint32_t dstStride, uint32_t transform) {
+    convertRect(src, dst, dstStride, transform, 0, 0, src.width, src.height);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Row kernels converting captured pixels into cairo's ARGB32 (little-endian BGRA in memory).
+// Every kernel has a scalar reference and SIMD variants picked at runtime; all of them produce byte-identical output.
+namespace NPixelConvert {
+    enum eBackend {
+        BACKEND_SCALAR = 0,
+        BACKEND_SSE2,
+        BACKEND_SSSE3,
+        BACKEND_AVX2,
+    };
+
+    // the backend in use, the best one this CPU supports unless setBackend changed it. Picked during static initialisation.
+    eBackend    backend();
+    // force a backend (for benchmarks and comparisons), returns false if the CPU can't run it.
+    // Safe while other threads convert: rows already started finish with the previous backend.
+    bool        setBackend(eBackend);
+    const char* backendName(eBackend);
+
+    // swaps the red and blue channels (ABGR8888 / XBGR8888). src and dst may alias.
+    void swapRB(const uint32_t* src, uint32_t* dst, size_t count);
+    // reduces 2:10:10:10 to 8:8:8:8, rounding to nearest. swapRB for XBGR2101010. src and dst may alias.
+    void reduce2101010(const uint32_t* src, uint32_t* dst, size_t count, bool swapRB);
+    // expands packed 24-bit pixels to 32-bit with opaque alpha. src and dst must not alias.
+    void expandBGR888(const uint8_t* src, uint32_t* dst, size_t count);
+    void expandRGB888(const uint8_t* src, uint32_t* dst, size_t count);
+
+    // bytes per pixel of a wl_shm format we can convert, 0 if unsupported
+    uint32_t bytesPerPixel(uint32_t format);
+    // converts a row segment of a supported format to ARGB32. src and dst may alias for 4-byte formats.
+    void convertRow(const uint8_t* src, uint32_t* dst, size_t count, uint32_t format);
+
+    struct SFrame {
+        const uint8_t* data   = nullptr;
+        uint32_t       width  = 0;
+        uint32_t       height = 0;
+        uint32_t       stride = 0;
+        uint32_t       format = 0;
+    };
+
+    // Converts the source rect [x0, x1) x [y0, y1) of a captured frame to ARGB32 and applies the wl_output_transform in the same pass,
+    // writing each destination pixel exactly once. dst is the transformed image (width and height swapped for 90/270).
+    // Converting NORMAL in place is allowed when dst == src.data and the strides match.
+    void convertRect(const SFrame& src, uint8_t* dst, uint32_t dstStride, uint32_t transform, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+    void convertFrame(const SFrame& src, uint8_t* dst, uint32_t dstStride, uint32_t transform);
+};
@@ -4,39 +4,59 @@
 SPoolBuffer::SPoolBuffer(const Vector2D& pixelSize_, uint32_t format_, uint32_t stride_) : stride(stride_), pixelSize(pixelSize_), format(format_) {
     const size_t SIZE = stride * pixelSize.y;
 
-    const auto   FD = g_pHyprpicker->createPoolFile(SIZE, name);
+    size = SIZE;
 
-    if (FD == -1) {
-        Debug::log(CRIT, "Unable to create pool file!");
-        g_pHyprpicker->finish(1);
-    }
+    const auto ARENA = g_pHyprpicker->m_pShmArena.get();
 
-    const auto DATA = mmap(nullptr, SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, FD, 0);
+    if (ARENA && ARENA->allocate(SIZE, slot)) {
+        data   = slot.data;
+        buffer = makeShared<CCWlBuffer>(ARENA->pool()->sendCreateBuffer(slot.offset, pixelSize.x, pixelSize.y, stride, format));
+    } else {
+        const auto FD = g_pHyprpicker->createPoolFile(SIZE, name);
 
-    size = SIZE;
-    data = DATA;
+        if (FD == -1) {
+            Debug::log(CRIT, "Unable to create pool file!");
+            g_pHyprpicker->finish(1);
+        }
 
-    auto POOL = makeShared<CCWlShmPool>(g_pHyprpicker->m_pSHM->sendCreatePool(FD, SIZE));
-    buffer    = makeShared<CCWlBuffer>(POOL->sendCreateBuffer(0, pixelSize.x, pixelSize.y, stride, format));
+        const auto DATA = mmap(nullptr, SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, FD, 0);
 
-    buffer->setRelease([this](CCWlBuffer* r) { busy = false; });
+        data = DATA;
+
+        auto POOL = makeShared<CCWlShmPool>(g_pHyprpicker->m_pSHM->sendCreatePool(FD, SIZE));
+        buffer    = makeShared<CCWlBuffer>(POOL->sendCreateBuffer(0, pixelSize.x, pixelSize.y, stride, format));
 
-    POOL.reset();
+        POOL.reset();
 
-    close(FD);
+        close(FD);
+    }
+
+    buffer->setRelease([this](CCWlBuffer* r) { busy = false; });
 }
 
 SPoolBuffer::~SPoolBuffer() {
-    buffer.reset();
     cairo_destroy(cairo);
     cairo_surface_destroy(surface);
-    munmap(data, size);
 
     cairo   = nullptr;
     surface = nullptr;
 
-    unlink(name.c_str());
+    if (slot.size) {
+        // the compositor may still read a buffer it hasn't released, its slot is only handed out again after the release
+        if (g_pHyprpicker->m_pShmArena) {
+            if (busy)
+                g_pHyprpicker->m_pShmArena->retire(buffer, slot);
+            else
+                g_pHyprpicker->m_pShmArena->release(slot);
+        }
+        buffer.reset();
+        return;
+    }
+
+    // a pool of its own isn't reused, the compositor keeps its own mapping of it
+    buffer.reset();
+
+    munmap(data, size);
 
-    if (paddedData)
-        free(paddedData);
+    unlink(name.c_str());
 }
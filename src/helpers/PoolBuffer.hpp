@@ -1,6 +1,17 @@
 #pragma once
 
 #include "../defines.hpp"
+#include "ShmArena.hpp"
+#include <hyprutils/math/Region.hpp>
+
+// what a render left in a buffer, so the next render into it only repaints what changed
+enum eBufferContent : uint8_t {
+    BUFFER_CONTENT_NONE = 0, // unknown, repaint everything
+    BUFFER_CONTENT_CLEAR,    // fully transparent
+    BUFFER_CONTENT_FROZEN,   // the frozen screen, nothing on top
+    BUFFER_CONTENT_ACTIVE,   // the frozen screen with the lens and labels in contentOverlay on top
+    BUFFER_CONTENT_LIVE,     // --live: transparent, with the lens and labels in contentOverlay on top
+};
 
 struct SPoolBuffer {
     SPoolBuffer(const Vector2D& size, uint32_t format, uint32_t stride);
@@ -11,16 +22,22 @@ struct SPoolBuffer {
     cairo_t*         cairo   = nullptr;
     void*            data    = nullptr;
 
-    // malloc'ed buffer for 24bit formats
-    void*       paddedData = nullptr;
-
     size_t      size   = 0;
     uint32_t    stride = 0;
     Vector2D    pixelSize;
 
     uint32_t    format;
 
-    std::string name;
+    // where the buffer lives in the shared arena, size 0 if it got a pool of its own (name is its file then)
+    CShmArena::SSlot slot;
+    std::string      name;
 
+    // attached and not released by the compositor yet
     bool        busy = false;
+
+    eBufferContent content       = BUFFER_CONTENT_NONE;
+    // CLayerSurface::screenBufferSerial of the frozen screen in the buffer
+    uint32_t       contentSerial = 0;
+    // buffer pixels covered by the overlay, for BUFFER_CONTENT_ACTIVE
+    CRegion        contentOverlay;
 };
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "Resample.hpp"
+#include "PixelConvert.hpp"
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HYPRPICKER_X86 1
+#include <immintrin.h>
+#endif
+
+// source pixels [first, first + count) with their coverage of one destination pixel, the weights of each pixel sum up to 1
+struct SContributions {
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> count;
+    std::vector<uint32_t> offset;
+    std::vector<float>    weights;
+};
+
+static SContributions contributions(uint32_t srcSize, uint32_t dstSize) {
+    SContributions c;
+    c.first.resize(dstSize);
+    c.count.resize(dstSize);
+    c.offset.resize(dstSize);
+
+    const double RATIO = (double)srcSize / dstSize;
+
+    for (uint32_t i = 0; i < dstSize; ++i) {
+        const double   A     = i * RATIO;
+        const double   B     = std::min((double)srcSize, (i + 1) * RATIO);
+        const uint32_t FIRST = std::min(srcSize - 1, (uint32_t)A);
+        const uint32_t LAST  = std::clamp((uint32_t)std::ceil(B), FIRST + 1, srcSize);
+
+        c.first[i]  = FIRST;
+        c.count[i]  = LAST - FIRST;
+        c.offset[i] = c.weights.size();
+
+        for (uint32_t j = FIRST; j < LAST; ++j) {
+            c.weights.push_back((std::min(B, j + 1.0) - std::max(A, (double)j)) / (B - A));
+        }
+    }
+
+    return c;
+}
+
+// row: one source row reduced horizontally, 4 floats (B, G, R, A in memory order) per destination pixel
+static void reduceRowScalar(const uint8_t* src, float* row, const SContributions& cx, size_t width) {
+    for (size_t x = 0; x < width; ++x) {
+        float        sum[4] = {0, 0, 0, 0};
+        const auto*  PX     = src + (size_t)cx.first[x] * 4;
+        const float* W      = cx.weights.data() + cx.offset[x];
+
+        for (uint32_t i = 0; i < cx.count[x]; ++i, PX += 4) {
+            for (size_t ch = 0; ch < 4; ++ch) {
+                sum[ch] += PX[ch] * W[i];
+            }
+        }
+
+        std::copy_n(sum, 4, row + x * 4);
+    }
+}
+
+static void accumulateScalar(float* acc, const float* row, float weight, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        acc[i] += row[i] * weight;
+    }
+}
+
+static void storeScalar(const float* acc, uint8_t* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = (uint8_t)std::min(255.F, acc[i] + 0.5F);
+    }
+}
+
+#ifdef HYPRPICKER_X86
+
+// one pixel is exactly one register, so channels never need to be shuffled
+static void reduceRowSSE2(const uint8_t* src, float* row, const SContributions& cx, size_t width) {
+    const __m128i ZERO = _mm_setzero_si128();
+
+    for (size_t x = 0; x < width; ++x) {
+        __m128       sum = _mm_setzero_ps();
+        const auto*  PX  = src + (size_t)cx.first[x] * 4;
+        const float* W   = cx.weights.data() + cx.offset[x];
+
+        for (uint32_t i = 0; i < cx.count[x]; ++i, PX += 4) {
+            const __m128i P  = _mm_cvtsi32_si128(*(const int32_t*)PX);
+            const __m128  PF = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(P, ZERO), ZERO));
+            sum              = _mm_add_ps(sum, _mm_mul_ps(PF, _mm_set1_ps(W[i])));
+        }
+
+        _mm_storeu_ps(row + x * 4, sum);
+    }
+}
+
+static void accumulateSSE2(float* acc, const float* row, float weight, size_t count) {
+    const __m128 W = _mm_set1_ps(weight);
+
+    size_t       i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(row + i), W)));
+    }
+
+    accumulateScalar(acc + i, row + i, weight, count - i);
+}
+
+static void storeSSE2(const float* acc, uint8_t* dst, size_t count) {
+    const __m128 HALF = _mm_set1_ps(0.5F);
+
+    size_t       i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i A = _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(acc + i), HALF));
+        const __m128i B = _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(acc + i + 4), HALF));
+        const __m128i C = _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(acc + i + 8), HALF));
+        const __m128i D = _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(acc + i + 12), HALF));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(_mm_packs_epi32(A, B), _mm_packs_epi32(C, D)));
+    }
+
+    storeScalar(acc + i, dst + i, count - i);
+}
+
+#endif
+
+void NResample::area(const SImage& src, const SImage& dst, CWorkerPool* pool) {
+    if (!src.data || !dst.data || src.width == 0 || src.height == 0 || dst.width == 0 || dst.height == 0)
+        return;
+
+    const auto CX = contributions(src.width, dst.width);
+    const auto CY = contributions(src.height, dst.height);
+
+    auto       reduceRow  = reduceRowScalar;
+    auto       accumulate = accumulateScalar;
+    auto       store      = storeScalar;
+
+#ifdef HYPRPICKER_X86
+    if (NPixelConvert::backend() >= NPixelConvert::BACKEND_SSE2) {
+        reduceRow  = reduceRowSSE2;
+        accumulate = accumulateSSE2;
+        store      = storeSSE2;
+    }
+#endif
+
+    const size_t ROWFLOATS = (size_t)dst.width * 4;
+
+    const auto   BAND = [&](size_t begin, size_t end) {
+        std::vector<float> row(ROWFLOATS), acc(ROWFLOATS);
+
+        for (size_t y = begin; y < end; ++y) {
+            std::fill(acc.begin(), acc.end(), 0.F);
+
+            const float* W = CY.weights.data() + CY.offset[y];
+            for (uint32_t i = 0; i < CY.count[y]; ++i) {
+                reduceRow(src.data + (size_t)(CY.first[y] + i) * src.stride, row.data(), CX, dst.width);
+                accumulate(acc.data(), row.data(), W[i], ROWFLOATS);
+            }
+
+            store(acc.data(), dst.data + y * dst.stride, ROWFLOATS);
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(dst.height, 16, BAND);
+    else
+        BAND(0, dst.height);
+}
+
+void NResample::copy(const SImage& src, const SImage& dst, const CRegion* clip, CWorkerPool* pool) {
+    if (!src.data || !dst.data || src.width != dst.width || src.height != dst.height)
+        return;
+
+    if (!clip) {
+        const auto ROWS = [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; ++y) {
+                memcpy(dst.data + y * dst.stride, src.data + y * src.stride, (size_t)src.width * 4);
+            }
+        };
+
+        if (pool)
+            pool->parallelFor(src.height, 64, ROWS);
+        else
+            ROWS(0, src.height);
+        return;
+    }
+
+    for (const auto& r : clip->getRects()) {
+        const int X1 = std::max(0, r.x1), Y1 = std::max(0, r.y1);
+        const int X2 = std::min((int)src.width, r.x2), Y2 = std::min((int)src.height, r.y2);
+
+        for (int y = Y1; y < Y2; ++y) {
+            memcpy(dst.data + (size_t)y * dst.stride + X1 * 4, src.data + (size_t)y * src.stride + X1 * 4, (size_t)std::max(0, X2 - X1) * 4);
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <hyprutils/math/Region.hpp>
+using namespace Hyprutils::Math;
+
+class CWorkerPool;
+
+// Resampling of whole ARGB32 images, used to bring a screenshot to the resolution it's displayed at.
+namespace NResample {
+    struct SImage {
+        uint8_t* data   = nullptr;
+        uint32_t width  = 0;
+        uint32_t height = 0;
+        uint32_t stride = 0;
+    };
+
+    // Area filter: every destination pixel is the average of the source area it covers, weighted by coverage.
+    // Unlike bilinear it doesn't alias at any ratio, and it degrades to a plain box filter for integer ratios.
+    // Works on premultiplied pixels as they are. Rows are split over the pool when one is given.
+    void area(const SImage& src, const SImage& dst, CWorkerPool* pool = nullptr);
+
+    // Copies src into dst of the same size, everywhere or only inside clip. Does nothing if the sizes differ.
+    void copy(const SImage& src, const SImage& dst, const CRegion* clip = nullptr, CWorkerPool* pool = nullptr);
+};
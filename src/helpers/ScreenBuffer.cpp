@@ -0,0 +1,153 @@
+#include "ScreenBuffer.hpp"
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include <wayland-client.h>
+
+// tiles are square in destination space and as big as the rotation tiles in NPixelConvert
+constexpr int TILE_SIZE = 64;
+
+CScreenBuffer::CScreenBuffer(void* captured, const Vector2D& capturedSize, uint32_t capturedStride, uint32_t format, uint32_t transform) : m_transform(transform) {
+    m_source = {.data = (const uint8_t*)captured, .width = (uint32_t)capturedSize.x, .height = (uint32_t)capturedSize.y, .stride = capturedStride, .format = format};
+
+    pixelSize = capturedSize;
+    if (transform % 2 == 1)
+        std::swap(pixelSize.x, pixelSize.y);
+
+    m_inPlace = transform == WL_OUTPUT_TRANSFORM_NORMAL && NPixelConvert::bytesPerPixel(format) == 4;
+
+    if (m_inPlace) {
+        stride = capturedStride;
+        data   = captured;
+    } else {
+        stride = (uint32_t)pixelSize.x * 4;
+        data   = malloc((size_t)stride * (size_t)pixelSize.y);
+    }
+
+    m_tilesX = ((size_t)pixelSize.x + TILE_SIZE - 1) / TILE_SIZE;
+    m_tilesY = ((size_t)pixelSize.y + TILE_SIZE - 1) / TILE_SIZE;
+    m_tileConverted.resize(m_tilesX * m_tilesY, 0);
+    m_tilesLeft = m_tilesX * m_tilesY;
+
+    surface = cairo_image_surface_create_for_data((unsigned char*)data, CAIRO_FORMAT_ARGB32, pixelSize.x, pixelSize.y, stride);
+}
+
+CScreenBuffer::~CScreenBuffer() {
+    if (surface)
+        cairo_surface_destroy(surface);
+
+    if (!m_inPlace)
+        free(data);
+}
+
+bool CScreenBuffer::good() const {
+    return data && NPixelConvert::bytesPerPixel(m_source.format);
+}
+
+bool CScreenBuffer::inPlace() const {
+    return m_inPlace;
+}
+
+bool CScreenBuffer::fullyConverted() const {
+    return m_tilesLeft == 0;
+}
+
+// maps a destination pixel back to the captured pixel it comes from, the inverse of NPixelConvert's mapping
+static std::pair<int, int> sourcePixel(uint32_t transform, int x, int y, int w, int h) {
+    switch (transform) {
+        case WL_OUTPUT_TRANSFORM_90: return {y, w - 1 - x};
+        case WL_OUTPUT_TRANSFORM_180: return {w - 1 - x, h - 1 - y};
+        case WL_OUTPUT_TRANSFORM_270: return {h - 1 - y, x};
+        case WL_OUTPUT_TRANSFORM_FLIPPED: return {w - 1 - x, y};
+        case WL_OUTPUT_TRANSFORM_FLIPPED_90: return {y, x};
+        case WL_OUTPUT_TRANSFORM_FLIPPED_180: return {x, h - 1 - y};
+        case WL_OUTPUT_TRANSFORM_FLIPPED_270: return {h - 1 - y, w - 1 - x};
+        default: return {x, y};
+    }
+}
+
+void CScreenBuffer::convertTile(size_t tx, size_t ty) {
+    auto& converted = m_tileConverted[(ty * m_tilesX) + tx];
+    if (converted)
+        return;
+
+    const int W = pixelSize.x, H = pixelSize.y;
+    const int X0 = tx * TILE_SIZE, Y0 = ty * TILE_SIZE;
+    const int X1 = std::min(X0 + TILE_SIZE, W), Y1 = std::min(Y0 + TILE_SIZE, H);
+
+    // a rect stays a rect under every transform, so two opposite corners are enough
+    const auto [AX, AY] = sourcePixel(m_transform, X0, Y0, W, H);
+    const auto [BX, BY] = sourcePixel(m_transform, X1 - 1, Y1 - 1, W, H);
+
+    NPixelConvert::convertRect(m_source, (uint8_t*)data, stride, m_transform, std::min(AX, BX), std::min(AY, BY), std::max(AX, BX) + 1, std::max(AY, BY) + 1);
+
+    converted = 1;
+    --m_tilesLeft;
+}
+
+void CScreenBuffer::ensureRect(int x, int y, int w, int h) {
+    if (fullyConverted() || !good())
+        return;
+
+    const int    X0 = std::clamp(x, 0, (int)pixelSize.x), Y0 = std::clamp(y, 0, (int)pixelSize.y);
+    const int    X1 = std::clamp(x + w, 0, (int)pixelSize.x), Y1 = std::clamp(y + h, 0, (int)pixelSize.y);
+
+    if (X0 >= X1 || Y0 >= Y1)
+        return;
+
+    bool         any = false;
+    for (size_t ty = Y0 / TILE_SIZE; ty <= (size_t)(Y1 - 1) / TILE_SIZE; ++ty) {
+        for (size_t tx = X0 / TILE_SIZE; tx <= (size_t)(X1 - 1) / TILE_SIZE; ++tx) {
+            any = any || !m_tileConverted[(ty * m_tilesX) + tx];
+            convertTile(tx, ty);
+        }
+    }
+
+    if (any)
+        cairo_surface_mark_dirty_rectangle(surface, X0, Y0, X1 - X0, Y1 - Y0);
+}
+
+void CScreenBuffer::refreshRect(const NPixelConvert::SFrame& capture, int x, int y, int w, int h) {
+    if (!good() || capture.width != m_source.width || capture.height != m_source.height || capture.format != m_source.format)
+        return;
+
+    const int W = pixelSize.x, H = pixelSize.y;
+    const int X0 = std::clamp(x, 0, W), Y0 = std::clamp(y, 0, H);
+    const int X1 = std::clamp(x + w, 0, W), Y1 = std::clamp(y + h, 0, H);
+
+    if (X0 >= X1 || Y0 >= Y1)
+        return;
+
+    // the tiles around the rect still come from the first capture, they have to be converted before it's written over
+    ensureRect(X0, Y0, X1 - X0, Y1 - Y0);
+
+    const auto [AX, AY] = sourcePixel(m_transform, X0, Y0, W, H);
+    const auto [BX, BY] = sourcePixel(m_transform, X1 - 1, Y1 - 1, W, H);
+
+    NPixelConvert::convertRect(capture, (uint8_t*)data, stride, m_transform, std::min(AX, BX), std::min(AY, BY), std::max(AX, BX) + 1, std::max(AY, BY) + 1);
+
+    cairo_surface_mark_dirty_rectangle(surface, X0, Y0, X1 - X0, Y1 - Y0);
+}
+
+void CScreenBuffer::ensureAll(CWorkerPool* pool) {
+    if (fullyConverted() || !good())
+        return;
+
+    // one job per row of tiles; rows write disjoint pixels and disjoint bitmap entries
+    const auto CONVERTROWS = [this](size_t begin, size_t end) {
+        for (size_t ty = begin; ty < end; ++ty) {
+            for (size_t tx = 0; tx < m_tilesX; ++tx) {
+                convertTile(tx, ty);
+            }
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(m_tilesY, 1, CONVERTROWS);
+    else
+        CONVERTROWS(0, m_tilesY);
+
+    cairo_surface_mark_dirty(surface);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <cairo/cairo.h>
+#include <hyprutils/math/Vector2D.hpp>
+using namespace Hyprutils::Math;
+
+#include "PixelConvert.hpp"
+
+class CWorkerPool;
+
+// The frozen screenshot of a monitor: ARGB32, in the monitor's logical orientation.
+// Pixels are converted lazily in tiles, the first time something reads them, so the captured memory
+// has to stay alive until fullyConverted(), and for as long as this object lives if inPlace().
+class CScreenBuffer {
+  public:
+    CScreenBuffer(void* captured, const Vector2D& capturedSize, uint32_t capturedStride, uint32_t format, uint32_t transform);
+    ~CScreenBuffer();
+
+    // false if the format can't be converted
+    bool                       good() const;
+
+    // converts the tiles covering a rect (in this buffer's pixels) that haven't been converted yet
+    void                       ensureRect(int x, int y, int w, int h);
+    // converts everything left, in parallel if a pool is given
+    void                       ensureAll(CWorkerPool* pool = nullptr);
+    bool                       fullyConverted() const;
+    // converts a rect (in this buffer's pixels) again from another capture of the same size and format
+    void                       refreshRect(const NPixelConvert::SFrame& capture, int x, int y, int w, int h);
+
+    // true if the pixels live in the captured buffer's memory (NORMAL 32-bit frames)
+    bool                       inPlace() const;
+
+    Vector2D                   pixelSize;
+    uint32_t                   stride  = 0;
+    void*                      data    = nullptr;
+    cairo_surface_t*           surface = nullptr;
+
+  private:
+    void                       convertTile(size_t tx, size_t ty);
+
+    NPixelConvert::SFrame      m_source;
+    uint32_t                   m_transform = 0;
+    bool                       m_inPlace   = false;
+
+    size_t                     m_tilesX = 0, m_tilesY = 0;
+    std::vector<uint8_t>       m_tileConverted;
+    std::atomic<size_t>        m_tilesLeft = 0;
+};
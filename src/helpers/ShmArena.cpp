@@ -0,0 +1,171 @@
+#include "ShmArena.hpp"
+#include "../hyprpicker.hpp"
+
+#include <cerrno>
+
+// wl_shm_pool sizes are int32
+constexpr size_t MAX_POOL_SIZE = INT32_MAX;
+
+static size_t pageSize() {
+    static const size_t PAGESIZE = sysconf(_SC_PAGESIZE);
+    return PAGESIZE;
+}
+
+static size_t alignToPage(size_t size) {
+    return (size + pageSize() - 1) & ~(pageSize() - 1);
+}
+
+CShmArena::CShmArena(bool prefault) : m_prefault(prefault) {
+    m_fd = memfd_create("hyprpicker-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+    if (m_fd >= 0) {
+        // the file only ever grows, let the compositor rely on that
+        if (fcntl(m_fd, F_ADD_SEALS, F_SEAL_SHRINK) < 0)
+            Debug::log(TRACE, "CShmArena: couldn't seal the memfd: %s", strerror(errno));
+    } else {
+        Debug::log(TRACE, "CShmArena: memfd_create failed (%s), using a file in XDG_RUNTIME_DIR", strerror(errno));
+
+        std::string name;
+        m_fd = g_pHyprpicker->createPoolFile(0, name);
+        unlink(name.c_str());
+    }
+
+    // address space only, nothing is committed until grow() maps the file over it
+    m_reserved = MAX_POOL_SIZE & ~(pageSize() - 1);
+
+    const auto BASE = mmap(nullptr, m_reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (BASE == MAP_FAILED) {
+        Debug::log(ERR, "CShmArena: couldn't reserve %zu bytes of address space, buffers will use their own pools", m_reserved);
+        m_reserved = 0;
+        return;
+    }
+
+    m_base = (uint8_t*)BASE;
+}
+
+CShmArena::~CShmArena() {
+    m_retired.clear();
+    m_pool.reset();
+
+    if (m_base)
+        munmap(m_base, m_reserved);
+
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+SP<CCWlShmPool> CShmArena::pool() const {
+    return m_pool;
+}
+
+bool CShmArena::allocate(size_t size, SSlot& slot) {
+    if (!m_base || size == 0)
+        return false;
+
+    const size_t SIZE = alignToPage(size);
+
+    auto         it = std::find_if(m_free.begin(), m_free.end(), [SIZE](const SRange& r) { return r.size >= SIZE; });
+
+    if (it != m_free.end()) {
+        slot = SSlot{.offset = it->offset, .size = SIZE, .data = m_base + it->offset};
+
+        it->offset += SIZE;
+        it->size -= SIZE;
+        if (it->size == 0)
+            m_free.erase(it);
+    } else {
+        // nothing fits, grow the file. A free range at the end becomes the start of the slot.
+        const bool   TAILFREE = !m_free.empty() && m_free.back().offset + m_free.back().size == m_size;
+        const size_t OFFSET   = TAILFREE ? m_free.back().offset : m_size;
+
+        if (OFFSET + SIZE > m_reserved || !grow(OFFSET + SIZE))
+            return false;
+
+        if (TAILFREE)
+            m_free.pop_back();
+
+        slot = SSlot{.offset = OFFSET, .size = SIZE, .data = m_base + OFFSET};
+    }
+
+#ifdef MADV_POPULATE_WRITE
+    if (m_prefault && madvise(slot.data, slot.size, MADV_POPULATE_WRITE) != 0)
+        Debug::log(TRACE, "CShmArena: MADV_POPULATE_WRITE failed: %s", strerror(errno));
+#endif
+
+    return true;
+}
+
+void CShmArena::release(const SSlot& slot) {
+    if (slot.size == 0)
+        return;
+
+    auto it = std::lower_bound(m_free.begin(), m_free.end(), slot.offset, [](const SRange& r, size_t offset) { return r.offset < offset; });
+    it      = m_free.insert(it, SRange{.offset = slot.offset, .size = slot.size});
+
+    // coalesce with the neighbours
+    if (it + 1 != m_free.end() && it->offset + it->size == (it + 1)->offset) {
+        it->size += (it + 1)->size;
+        m_free.erase(it + 1);
+    }
+
+    if (it != m_free.begin() && (it - 1)->offset + (it - 1)->size == it->offset) {
+        (it - 1)->size += it->size;
+        m_free.erase(it);
+    }
+}
+
+void CShmArena::retire(SP<CCWlBuffer> buffer, const SSlot& slot) {
+    if (slot.size == 0)
+        return;
+
+    // replaces whatever listener the buffer had, its owner is gone
+    buffer->setRelease([this](CCWlBuffer* r) { onRetiredRelease(r); });
+    m_retired.emplace_back(SRetired{.buffer = buffer, .slot = slot});
+}
+
+void CShmArena::onRetiredRelease(CCWlBuffer* buffer) {
+    const auto IT = std::ranges::find_if(m_retired, [buffer](const SRetired& r) { return r.buffer.get() == buffer; });
+    if (IT == m_retired.end())
+        return;
+
+    // erasing the entry destroys the wl_buffer whose release listener this runs in, so the slot is copied out first and nothing of it is touched after
+    const auto SLOT = IT->slot;
+    m_retired.erase(IT);
+    release(SLOT);
+}
+
+void CShmArena::freeRetired() {
+    for (const auto& r : m_retired) {
+        release(r.slot);
+    }
+
+    m_retired.clear();
+}
+
+bool CShmArena::grow(size_t newSize) {
+    if (ftruncate(m_fd, newSize) < 0) {
+        Debug::log(ERR, "CShmArena: ftruncate to %zu failed: %s", newSize, strerror(errno));
+        return false;
+    }
+
+    // map the new part of the file over its reserved range, existing slots stay where they are
+    const auto GROWN = m_base + m_size;
+    if (mmap(GROWN, newSize - m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, m_fd, m_size) == MAP_FAILED) {
+        Debug::log(ERR, "CShmArena: mmap of %zu bytes failed: %s", newSize - m_size, strerror(errno));
+        return false;
+    }
+
+    if (m_prefault)
+        madvise(GROWN, newSize - m_size, MADV_HUGEPAGE);
+
+    if (!m_pool)
+        m_pool = makeShared<CCWlShmPool>(g_pHyprpicker->m_pSHM->sendCreatePool(m_fd, newSize));
+    else
+        m_pool->sendResize(newSize);
+
+    Debug::log(TRACE, "CShmArena: pool grown to %zu bytes", newSize);
+
+    m_size = newSize;
+
+    return true;
+}
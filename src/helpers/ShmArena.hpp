@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../defines.hpp"
+
+// One memfd and one wl_shm_pool shared by every SPoolBuffer.
+// The whole pool range is reserved in our address space up front, so growing it (ftruncate + wl_shm_pool.resize)
+// maps more of the file in place and never moves slots that are already handed out.
+class CShmArena {
+  public:
+    // prefault: populate the pages of every new slot (and ask for hugepages) instead of faulting them in on first use
+    CShmArena(bool prefault = false);
+    ~CShmArena();
+
+    struct SSlot {
+        size_t offset = 0;
+        size_t size   = 0;
+        void*  data   = nullptr;
+    };
+
+    // false if the arena is unusable or full, callers then fall back to a pool of their own
+    bool            allocate(size_t size, SSlot& slot);
+    void            release(const SSlot& slot);
+    // for a slot whose buffer the compositor still holds: keeps the buffer alive and frees the slot on its wl_buffer.release,
+    // so nothing else is rendered into memory that may still be read or shown
+    void            retire(SP<CCWlBuffer> buffer, const SSlot& slot);
+    // frees every retired slot now, once the surfaces that held them are gone
+    void            freeRetired();
+
+    SP<CCWlShmPool> pool() const;
+
+  private:
+    bool            grow(size_t newSize);
+    void            onRetiredRelease(CCWlBuffer* buffer);
+
+    int             m_fd       = -1;
+    uint8_t*        m_base     = nullptr;
+    size_t          m_reserved = 0;
+    size_t          m_size     = 0;
+    bool            m_prefault = false;
+
+    SP<CCWlShmPool> m_pool;
+
+    // free ranges, sorted by offset and coalesced
+    struct SRange {
+        size_t offset = 0;
+        size_t size   = 0;
+    };
+    std::vector<SRange> m_free;
+
+    struct SRetired {
+        SP<CCWlBuffer> buffer;
+        SSlot          slot;
+    };
+    std::vector<SRetired> m_retired;
+};
@@ -0,0 +1,135 @@
+#include "Swapchain.hpp"
+#include "../hyprpicker.hpp"
+
+using namespace std::chrono;
+
+CSwapchain::CSwapchain() = default;
+
+CSwapchain::~CSwapchain() {
+    logStats();
+}
+
+void CSwapchain::resize(const Vector2D& size) {
+    if (!m_buffers.empty())
+        logStats();
+
+    // free the idle slots first so the new buffers can take their place in the arena. The compositor may still read or show the others.
+    for (auto& b : m_buffers) {
+        if (b.buffer->busy)
+            m_retired.emplace_back(std::move(b));
+    }
+
+    m_buffers.clear();
+    m_size = size;
+
+    for (size_t i = 0; i < MIN_BUFFERS; ++i) {
+        addBuffer();
+    }
+}
+
+Vector2D CSwapchain::size() const {
+    return m_size;
+}
+
+bool CSwapchain::empty() const {
+    return m_buffers.empty();
+}
+
+SP<SPoolBuffer> CSwapchain::addBuffer() {
+    auto& b = m_buffers.emplace_back(SBuffer{.buffer = makeShared<SPoolBuffer>(m_size, WL_SHM_FORMAT_ARGB8888, m_size.x * 4)});
+
+    // replaces SPoolBuffer's own listener, so also clear busy here
+    b.buffer->buffer->setRelease([this, BUFFER = b.buffer.get()](CCWlBuffer* r) { onBufferRelease(BUFFER); });
+
+    return b.buffer;
+}
+
+void CSwapchain::onBufferRelease(SPoolBuffer* buffer) {
+    const auto RETIRED = std::ranges::find_if(m_retired, [buffer](const SBuffer& b) { return b.buffer.get() == buffer; });
+    if (RETIRED != m_retired.end()) {
+        // the compositor is done with it, so the slot can go back to the arena right away. Erasing drops the last reference,
+        // which destroys the wl_buffer whose release listener this runs in: buffer must not be used after.
+        RETIRED->buffer->busy = false;
+        m_retired.erase(RETIRED);
+        return;
+    }
+
+    const auto IT = std::ranges::find_if(m_buffers, [buffer](const SBuffer& b) { return b.buffer.get() == buffer; });
+    if (IT == m_buffers.end())
+        return;
+
+    const auto HELD = duration_cast<microseconds>(steady_clock::now() - IT->submittedAt);
+
+    IT->buffer->busy = false;
+    IT->releases++;
+    IT->heldTotal += HELD;
+    IT->heldMax = std::max(IT->heldMax, HELD);
+
+    if (onRelease)
+        onRelease();
+}
+
+SP<SPoolBuffer> CSwapchain::acquire() {
+    for (auto& b : m_buffers) {
+        if (b.buffer->busy)
+            continue;
+
+        m_acquiredAt = steady_clock::now();
+        return b.buffer;
+    }
+
+    if (m_buffers.empty())
+        return nullptr;
+
+    const auto NOW = steady_clock::now();
+
+    if (m_buffers.size() < MAX_BUFFERS) {
+        auto buffer = addBuffer();
+        Debug::log(TRACE, "swapchain %s: all buffers held, grew to %zu", name.c_str(), m_buffers.size());
+        m_acquiredAt = NOW;
+        return buffer;
+    }
+
+    droppedRenders++;
+
+    const auto OLDEST = std::ranges::min_element(m_buffers, {}, &SBuffer::submittedAt);
+    Debug::log(TRACE, "swapchain %s: dropped a render, all %zu buffers held by the compositor (oldest for %.2fms), %zu dropped so far", name.c_str(), m_buffers.size(),
+               duration_cast<microseconds>(NOW - OLDEST->submittedAt).count() / 1000.0, droppedRenders);
+
+    return nullptr;
+}
+
+void CSwapchain::submitted(const SP<SPoolBuffer>& buffer) {
+    const auto NOW = steady_clock::now();
+
+    for (auto& b : m_buffers) {
+        if (b.buffer != buffer)
+            continue;
+
+        b.buffer->busy = true;
+        b.submittedAt  = NOW;
+        break;
+    }
+
+    const auto RENDER = duration_cast<microseconds>(NOW - m_acquiredAt);
+    m_renders++;
+    m_renderTotal += RENDER;
+    m_renderMax = std::max(m_renderMax, RENDER);
+}
+
+void CSwapchain::logStats() const {
+    if (m_renders == 0)
+        return;
+
+    Debug::log(TRACE, "swapchain %s: %zu renders, avg %.2fms max %.2fms, %zu dropped, %zu buffers", name.c_str(), m_renders, m_renderTotal.count() / 1000.0 / m_renders,
+               m_renderMax.count() / 1000.0, droppedRenders, m_buffers.size());
+
+    for (size_t i = 0; i < m_buffers.size(); ++i) {
+        const auto& b = m_buffers[i];
+        if (b.releases == 0)
+            continue;
+
+        Debug::log(TRACE, "swapchain %s: buffer %zu released %zu times, held avg %.2fms max %.2fms", name.c_str(), i, b.releases, b.heldTotal.count() / 1000.0 / b.releases,
+                   b.heldMax.count() / 1000.0);
+    }
+}
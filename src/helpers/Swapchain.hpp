@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../defines.hpp"
+#include "PoolBuffer.hpp"
+
+#include <chrono>
+#include <functional>
+
+// The render buffers of one surface. Starts with MIN_BUFFERS and grows up to MAX_BUFFERS while the compositor holds on to releases,
+// so a slow release costs one more buffer instead of a dropped frame. Keeps track of how long buffers are held and how long we take to
+// render, so verbose logs can tell compositor back-pressure apart from our own render cost.
+class CSwapchain {
+  public:
+    CSwapchain();
+    ~CSwapchain();
+
+    static constexpr size_t MIN_BUFFERS = 2;
+    static constexpr size_t MAX_BUFFERS = 4;
+
+    // allocates MIN_BUFFERS of the new size. Idle old buffers are freed first so the new ones can take their place, the ones the
+    // compositor still holds are retired and only freed once it releases them.
+    void                    resize(const Vector2D& size);
+    Vector2D                size() const;
+    bool                    empty() const;
+
+    // a buffer the compositor doesn't hold, growing the chain if needed. nullptr if all MAX_BUFFERS are held, which counts as a dropped render.
+    SP<SPoolBuffer>         acquire();
+    // the buffer returned by acquire() was attached and committed
+    void                    submitted(const SP<SPoolBuffer>& buffer);
+
+    void                    logStats() const;
+
+    // used in logs
+    std::string             name;
+    // called when the compositor releases a buffer
+    std::function<void()>   onRelease;
+
+    size_t                  droppedRenders = 0;
+
+  private:
+    struct SBuffer {
+        SP<SPoolBuffer>                       buffer;
+        std::chrono::steady_clock::time_point submittedAt;
+        size_t                                releases = 0;
+        std::chrono::microseconds             heldTotal{0};
+        std::chrono::microseconds             heldMax{0};
+    };
+
+    SP<SPoolBuffer>                       addBuffer();
+    void                                  onBufferRelease(SPoolBuffer* buffer);
+
+    std::vector<SBuffer>                  m_buffers;
+    // buffers of an old size the compositor still held at resize(), dropped once released
+    std::vector<SBuffer>                  m_retired;
+    Vector2D                              m_size;
+
+    std::chrono::steady_clock::time_point m_acquiredAt;
+    size_t                                m_renders = 0;
+    std::chrono::microseconds             m_renderTotal{0};
+    std::chrono::microseconds             m_renderMax{0};
+};
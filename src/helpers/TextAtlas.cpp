@@ -0,0 +1,177 @@
+#include "TextAtlas.hpp"
+#include "../debug/Log.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <pango/pangocairo.h>
+
+// room around every glyph for ink that leaves its logical box
+constexpr int    PAD = 2;
+// masks not drawn within this many draws are dropped once there are more than this many
+constexpr size_t MAX_MASKS = 512;
+
+CTextAtlas::CTextAtlas(const std::string& font, double size) {
+    m_context = pango_font_map_create_context(pango_cairo_font_map_get_default());
+
+    const auto DESC = pango_font_description_from_string(font.c_str());
+    pango_font_description_set_absolute_size(DESC, size * PANGO_SCALE);
+    pango_context_set_font_description(m_context, DESC);
+
+    if (const auto LOADED = pango_context_load_font(m_context, DESC); LOADED) {
+        const auto RESOLVED = pango_font_describe(LOADED);
+        const auto NAME     = pango_font_description_to_string(RESOLVED);
+        Debug::log(TRACE, "CTextAtlas: %s resolved to %s", font.c_str(), NAME);
+        g_free(NAME);
+        pango_font_description_free(RESOLVED);
+        g_object_unref(LOADED);
+    }
+
+    pango_font_description_free(DESC);
+
+    // line metrics from something with ascenders and descenders
+    const auto LAYOUT = pango_layout_new(m_context);
+    pango_layout_set_text(LAYOUT, "#0Ag", -1);
+
+    PangoRectangle logical;
+    pango_layout_get_extents(LAYOUT, nullptr, &logical);
+    m_height   = (int)std::ceil((double)logical.height / PANGO_SCALE) + 2 * PAD;
+    m_baseline = (int)std::lround((double)pango_layout_get_baseline(LAYOUT) / PANGO_SCALE) + PAD;
+
+    g_object_unref(LAYOUT);
+
+    // what labels are made of, the rest is added when first used
+    for (const char c : std::string{"0123456789ABCDEFabcdef#% .-"}) {
+        glyph(c);
+    }
+}
+
+CTextAtlas::~CTextAtlas() {
+    for (auto& [text, mask] : m_masks) {
+        cairo_surface_destroy(mask.surface);
+    }
+
+    if (m_context)
+        g_object_unref(m_context);
+}
+
+const CTextAtlas::SGlyph& CTextAtlas::glyph(char c) {
+    // anything outside of ASCII is drawn as nothing
+    static const SGlyph EMPTY;
+    if (c < 0)
+        return EMPTY;
+
+    auto& g = m_glyphs[(size_t)c];
+    if (g.ready)
+        return g;
+
+    const auto LAYOUT = pango_layout_new(m_context);
+    pango_layout_set_text(LAYOUT, &c, 1);
+
+    PangoRectangle logical;
+    pango_layout_get_extents(LAYOUT, nullptr, &logical);
+
+    g.ready   = true;
+    g.advance = (double)logical.width / PANGO_SCALE;
+    g.width   = (int)std::ceil(g.advance) + 2 * PAD;
+    g.x       = m_atlasWidth;
+
+    const auto SURFACE = cairo_image_surface_create(CAIRO_FORMAT_A8, g.width, m_height);
+    const auto CR      = cairo_create(SURFACE);
+    pango_cairo_update_context(CR, m_context);
+    cairo_move_to(CR, PAD, PAD);
+    pango_cairo_show_layout(CR, LAYOUT);
+    cairo_destroy(CR);
+    cairo_surface_flush(SURFACE);
+
+    g_object_unref(LAYOUT);
+
+    // append the cell to the right of the atlas
+    const int            NEWWIDTH = m_atlasWidth + g.width;
+    std::vector<uint8_t> atlas((size_t)NEWWIDTH * m_height, 0);
+
+    const auto           DATA   = cairo_image_surface_get_data(SURFACE);
+    const auto           STRIDE = cairo_image_surface_get_stride(SURFACE);
+    for (int y = 0; y < m_height; ++y) {
+        if (m_atlasWidth > 0)
+            memcpy(atlas.data() + (size_t)y * NEWWIDTH, m_atlas.data() + (size_t)y * m_atlasWidth, m_atlasWidth);
+        memcpy(atlas.data() + (size_t)y * NEWWIDTH + g.x, DATA + (size_t)y * STRIDE, g.width);
+    }
+
+    cairo_surface_destroy(SURFACE);
+
+    m_atlas      = std::move(atlas);
+    m_atlasWidth = NEWWIDTH;
+
+    return g;
+}
+
+double CTextAtlas::measure(const std::string& text) {
+    double width = 0;
+    for (const char c : text) {
+        width += glyph(c).advance;
+    }
+
+    return width;
+}
+
+CTextAtlas::SMask& CTextAtlas::mask(const std::string& text) {
+    m_frame++;
+
+    if (auto it = m_masks.find(text); it != m_masks.end()) {
+        it->second.used = m_frame;
+        return it->second;
+    }
+
+    if (m_masks.size() >= MAX_MASKS) {
+        std::erase_if(m_masks, [this](auto& entry) {
+            if (entry.second.used + MAX_MASKS >= m_frame)
+                return false;
+
+            cairo_surface_destroy(entry.second.surface);
+            return true;
+        });
+    }
+
+    // glyph cells overlap by their padding, their coverage adds up there
+    SMask m;
+    m.width   = (int)std::ceil(measure(text)) + 2 * PAD;
+    m.surface = cairo_image_surface_create(CAIRO_FORMAT_A8, m.width, m_height);
+    m.used    = m_frame;
+
+    const auto DATA   = cairo_image_surface_get_data(m.surface);
+    const auto STRIDE = cairo_image_surface_get_stride(m.surface);
+
+    double     pen = 0;
+    for (const char c : text) {
+        const auto& G  = glyph(c);
+        const int   GX = (int)std::lround(pen);
+        const int   W  = std::min(G.width, m.width - GX);
+
+        for (int y = 0; y < m_height; ++y) {
+            const auto SRC = m_atlas.data() + (size_t)y * m_atlasWidth + G.x;
+            const auto DST = DATA + (size_t)y * STRIDE + GX;
+            for (int x = 0; x < W; ++x) {
+                DST[x] = std::min(255, DST[x] + SRC[x]);
+            }
+        }
+
+        pen += G.advance;
+    }
+
+    cairo_surface_mark_dirty(m.surface);
+
+    return m_masks.emplace(text, m).first->second;
+}
+
+CBox CTextAtlas::draw(cairo_t* cr, const std::string& text, double x, double y) {
+    const auto& M = mask(text);
+
+    // whole pixels keep the glyphs as crisp as they were rasterized
+    const double X = std::round(x) - PAD;
+    const double Y = std::round(y) - m_baseline;
+
+    cairo_mask_surface(cr, M.surface, X, Y);
+
+    return {X, Y, (double)M.width, (double)m_height};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cairo/cairo.h>
+#include <hyprutils/math/Box.hpp>
+using namespace Hyprutils::Math;
+
+typedef struct _PangoContext PangoContext;
+
+// Single-line ASCII text in one font and size, for the preview labels.
+// The font is resolved through pango once. Glyphs are rasterized the first time they're used into an alpha atlas,
+// and every string gets an alpha mask built from the atlas that is kept for as long as it keeps being drawn.
+class CTextAtlas {
+  public:
+    CTextAtlas(const std::string& font, double size);
+    ~CTextAtlas();
+
+    // advance width of text, in pixels
+    double measure(const std::string& text);
+    // fills text with the current source of cr, pen at x on the baseline y. Returns the pixels that may have been touched.
+    CBox   draw(cairo_t* cr, const std::string& text, double x, double y);
+
+  private:
+    struct SGlyph {
+        bool   ready = false;
+        // column of the glyph's cell in the atlas, the pen origin is PAD pixels into it
+        int    x       = 0;
+        int    width   = 0;
+        double advance = 0;
+    };
+
+    struct SMask {
+        cairo_surface_t* surface = nullptr;
+        int              width   = 0;
+        uint64_t         used    = 0;
+    };
+
+    const SGlyph&                            glyph(char c);
+    SMask&                                   mask(const std::string& text);
+
+    PangoContext*                            m_context = nullptr;
+
+    std::array<SGlyph, 128>                  m_glyphs;
+
+    // A8, one row of glyph cells m_height tall
+    std::vector<uint8_t>                     m_atlas;
+    int                                      m_atlasWidth = 0;
+    int                                      m_height     = 0;
+    int                                      m_baseline   = 0;
+
+    std::unordered_map<std::string, SMask>   m_masks;
+    uint64_t                                 m_frame = 0;
+};
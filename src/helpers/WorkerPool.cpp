@@ -0,0 +1,87 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+CWorkerPool::CWorkerPool(size_t threads) {
+    if (threads == 0)
+        threads = std::max(1U, std::thread::hardware_concurrency());
+
+    for (size_t i = 1; i < threads; ++i) {
+        m_threads.emplace_back([this]() { workerMain(); });
+    }
+}
+
+CWorkerPool::~CWorkerPool() {
+    {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_stopping = true;
+    }
+
+    m_cvWork.notify_all();
+
+    for (auto& t : m_threads) {
+        t.join();
+    }
+}
+
+size_t CWorkerPool::threads() const {
+    return m_threads.size() + 1;
+}
+
+void CWorkerPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    if (count == 0)
+        return;
+
+    grain = std::max<size_t>(grain, 1);
+
+    if (m_threads.empty() || count <= grain) {
+        fn(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_fn      = &fn;
+        m_count   = count;
+        m_grain   = grain;
+        m_next    = 0;
+        m_pending = m_threads.size();
+        ++m_generation;
+    }
+
+    m_cvWork.notify_all();
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    m_cvDone.wait(lk, [this]() { return m_pending == 0; });
+    m_fn = nullptr;
+}
+
+void CWorkerPool::runChunks() {
+    size_t begin = 0;
+    while ((begin = m_next.fetch_add(m_grain)) < m_count) {
+        (*m_fn)(begin, std::min(begin + m_grain, m_count));
+    }
+}
+
+void CWorkerPool::workerMain() {
+    uint64_t seen = 0;
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    while (true) {
+        m_cvWork.wait(lk, [this, &seen]() { return m_stopping || m_generation != seen; });
+
+        if (m_stopping)
+            return;
+
+        seen = m_generation;
+
+        lk.unlock();
+        runChunks();
+        lk.lock();
+
+        if (--m_pending == 0)
+            m_cvDone.notify_one();
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for splitting per-pixel work into bands.
+// parallelFor is meant to be called from one thread at a time (the wayland thread), which also takes a share of the work.
+class CWorkerPool {
+  public:
+    // threads is the total number of threads working on a job, including the caller. 0 picks one per core.
+    CWorkerPool(size_t threads = 0);
+    ~CWorkerPool();
+
+    size_t threads() const;
+
+    // calls fn(begin, end) for consecutive chunks of at most grain items covering [0, count), returns once all of them ran
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+  private:
+    void                                      workerMain();
+    void                                      runChunks();
+
+    std::vector<std::thread>                  m_threads;
+    std::mutex                                m_mutex;
+    std::condition_variable                   m_cvWork;
+    std::condition_variable                   m_cvDone;
+    uint64_t                                  m_generation = 0;
+    size_t                                    m_pending    = 0;
+    bool                                      m_stopping   = false;
+
+    const std::function<void(size_t, size_t)>* m_fn    = nullptr;
+    size_t                                    m_count = 0;
+    size_t                                    m_grain = 1;
+    std::atomic<size_t>                       m_next  = 0;
+};
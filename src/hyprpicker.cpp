@@ -1,21 +1,46 @@
 #include "hyprpicker.hpp"
 #include "src/notify/Notify.hpp"
+#include "helpers/Overlay.hpp"
+#include "helpers/PixelConvert.hpp"
+#include "daemon/Daemon.hpp"
 #include <csignal>
+#include <poll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <charconv>
+#include <chrono>
 #include <cstddef>
 #include <cstdio>
 #include <format>
 
-static void sigHandler(int sig) {
-    g_pHyprpicker->m_vLayerSurfaces.clear();
-    exit(0);
-}
-
 void CHyprpicker::init() {
+    if (!m_szImagePath.empty()) {
+        sampleImage();
+        return;
+    }
+
+    if (m_bPickAt) {
+        pickAt();
+        return;
+    }
+
+    if (m_bWatch) {
+        watch();
+        return;
+    }
+
+    if (m_bTrigger && triggerDaemon())
+        return;
+
+    const uint64_t STARTEDAT = Stats::now();
+
     m_pXKBContext = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
     if (!m_pXKBContext)
         Debug::log(ERR, "Failed to create xkb context");
 
-    m_pWLDisplay = wl_display_connect(nullptr);
+    uint64_t stageStart = Stats::now();
+    m_pWLDisplay        = wl_display_connect(nullptr);
+    Stats::record(Stats::STAGE_CONNECT, "", stageStart);
 
     if (!m_pWLDisplay) {
         Debug::log(CRIT, "No wayland compositor running!");
@@ -23,12 +48,12 @@ void CHyprpicker::init() {
         return;
     }
 
-    signal(SIGTERM, sigHandler);
-
     m_pRegistry = makeShared<CCWlRegistry>((wl_proxy*)wl_display_get_registry(m_pWLDisplay));
     m_pRegistry->setGlobal([this](CCWlRegistry* r, uint32_t name, const char* interface, uint32_t version) {
         if (strcmp(interface, wl_compositor_interface.name) == 0) {
             m_pCompositor = makeShared<CCWlCompositor>((wl_proxy*)wl_registry_bind((wl_registry*)m_pRegistry->resource(), name, &wl_compositor_interface, 4));
+        } else if (strcmp(interface, wl_subcompositor_interface.name) == 0) {
+            m_pSubcompositor = makeShared<CCWlSubcompositor>((wl_proxy*)wl_registry_bind((wl_registry*)m_pRegistry->resource(), name, &wl_subcompositor_interface, 1));
         } else if (strcmp(interface, wl_shm_interface.name) == 0) {
             m_pSHM = makeShared<CCWlShm>((wl_proxy*)wl_registry_bind((wl_registry*)m_pRegistry->resource(), name, &wl_shm_interface, 1));
         } else if (strcmp(interface, wl_output_interface.name) == 0) {
@@ -53,7 +78,7 @@ void CHyprpicker::init() {
                     if (!m_pPointer) {
                         m_pPointer = makeShared<CCWlPointer>(m_pSeat->sendGetPointer());
                         initMouse();
-                        if (m_pCursorShapeMgr)
+                        if (m_pCursorShapeMgr && m_bStartupDone)
                             m_pCursorShapeDevice = makeShared<CCWpCursorShapeDeviceV1>(m_pCursorShapeMgr->sendGetPointer(m_pPointer->resource()));
                     }
                 } else {
@@ -71,8 +96,10 @@ void CHyprpicker::init() {
             });
 
         } else if (strcmp(interface, zwlr_screencopy_manager_v1_interface.name) == 0) {
-            m_pScreencopyMgr =
-                makeShared<CCZwlrScreencopyManagerV1>((wl_proxy*)wl_registry_bind((wl_registry*)m_pRegistry->resource(), name, &zwlr_screencopy_manager_v1_interface, 1));
+            // version 3 adds dmabuf events the capture code doesn't wait for
+            m_iScreencopyVersion = std::min<uint32_t>(version, 2);
+            m_pScreencopyMgr     = makeShared<CCZwlrScreencopyManagerV1>(
+                (wl_proxy*)wl_registry_bind((wl_registry*)m_pRegistry->resource(), name, &zwlr_screencopy_manager_v1_interface, m_iScreencopyVersion));
         } else if (strcmp(interface, wp_cursor_shape_manager_v1_interface.name) == 0) {
             m_pCursorShapeMgr =
                 makeShared<CCWpCursorShapeManagerV1>((wl_proxy*)wl_registry_bind((wl_registry*)m_pRegistry->resource(), name, &wp_cursor_shape_manager_v1_interface, 1));
@@ -81,10 +108,34 @@ void CHyprpicker::init() {
                 makeShared<CCWpFractionalScaleManagerV1>((wl_proxy*)wl_registry_bind((wl_registry*)m_pRegistry->resource(), name, &wp_fractional_scale_manager_v1_interface, 1));
         } else if (strcmp(interface, wp_viewporter_interface.name) == 0) {
             m_pViewporter = makeShared<CCWpViewporter>((wl_proxy*)wl_registry_bind((wl_registry*)m_pRegistry->resource(), name, &wp_viewporter_interface, 1));
+        } else if (strcmp(interface, zxdg_output_manager_v1_interface.name) == 0) {
+            m_pXDGOutputMgr =
+                makeShared<CCZxdgOutputManagerV1>((wl_proxy*)wl_registry_bind((wl_registry*)m_pRegistry->resource(), name, &zxdg_output_manager_v1_interface, 2));
         }
     });
 
+    m_pRegistry->setGlobalRemove([this](CCWlRegistry* r, uint32_t name) {
+        // a single pick doesn't outlive the outputs it started with, only a daemon has to forget about unplugged ones
+        if (!m_bDaemon)
+            return;
+
+        const auto IT = std::ranges::find_if(m_vMonitors, [name](const auto& m) { return m->wayland_name == name; });
+        if (IT == m_vMonitors.end())
+            return;
+
+        if (m_bSessionActive) {
+            Debug::log(WARN, "Output %s went away, cancelling the pick", (*IT)->name.c_str());
+            endSession(2);
+        }
+
+        m_mtTickMutex.lock();
+        m_vMonitors.erase(IT);
+        m_mtTickMutex.unlock();
+    });
+
+    stageStart = Stats::now();
     wl_display_roundtrip(m_pWLDisplay);
+    Stats::record(Stats::STAGE_REGISTRY, "", stageStart);
 
     // Cursor shape protocol is optional and not required when hiding cursor
     if (!m_pCursorShapeMgr)
@@ -95,6 +146,25 @@ void CHyprpicker::init() {
         exit(1);
     }
 
+    m_pShmArena = std::make_unique<CShmArena>(m_bPrefault);
+
+    // signals are read from the main loop, blocked before any thread exists so none of them gets one delivered
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+
+    m_iSignalFD = signalfd(-1, &signals, SFD_CLOEXEC | SFD_NONBLOCK);
+    if (m_iSignalFD < 0) {
+        Debug::log(CRIT, "Couldn't create a signalfd: %s", strerror(errno));
+        exit(1);
+    }
+
+    m_pWorkerPool = std::make_unique<CWorkerPool>(m_iThreads);
+
+    Debug::log(TRACE, "Pixel conversion backend: %s, %zu threads", NPixelConvert::backendName(NPixelConvert::backend()), m_pWorkerPool->threads());
+
     if (!m_pFractionalMgr) {
         Debug::log(WARN, "wp_fractional_scale_v1 not supported, fractional scaling won't work");
         m_bNoFractional = true;
@@ -103,9 +173,104 @@ void CHyprpicker::init() {
         Debug::log(WARN, "wp_viewporter not supported, fractional scaling won't work");
         m_bNoFractional = true;
     }
+    if (m_bSubsurface && (!m_pSubcompositor || !m_pViewporter)) {
+        Debug::log(WARN, "wl_subcompositor or wp_viewporter not supported, --subsurface won't work");
+        m_bSubsurface = false;
+    }
 
     // Use system cursor shape; no custom cursor drawing
 
+    m_iRepeatFD = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (m_iRepeatFD < 0) {
+        Debug::log(CRIT, "Couldn't create a timerfd: %s", strerror(errno));
+        exit(1);
+    }
+
+    if (m_bDaemon) {
+        m_szSocketPath = NDaemon::socketPath();
+        m_iDaemonFD    = NDaemon::listen(m_szSocketPath);
+        if (m_iDaemonFD < 0) {
+            Debug::log(CRIT, "Couldn't start the daemon");
+            exit(1);
+        }
+
+        // results go to the clients, which may not be terminals
+        m_bFancyOutput = false;
+
+        Debug::log(LOG, "Waiting for picks on %s", m_szSocketPath.c_str());
+    } else
+        startSession(STARTEDAT);
+
+    // no roundtrip here: every monitor is handled by the loop as its events come in, without waiting for the others
+    const int WLFD = wl_display_get_fd(m_pWLDisplay);
+
+    while (m_bRunning) {
+        while (wl_display_prepare_read(m_pWLDisplay) != 0) {
+            if (wl_display_dispatch_pending(m_pWLDisplay) < 0)
+                break;
+        }
+
+        wl_display_flush(m_pWLDisplay);
+
+        // the socket fds are -1 (and ignored by poll) unless a daemon listens or has a client
+        pollfd fds[] = {{.fd = WLFD, .events = POLLIN},
+                        {.fd = m_iRepeatFD, .events = POLLIN},
+                        {.fd = m_iSignalFD, .events = POLLIN},
+                        {.fd = m_iClientFD, .events = POLLIN},
+                        {.fd = m_iDaemonFD, .events = POLLIN}};
+        if (poll(fds, 5, -1) < 0) {
+            wl_display_cancel_read(m_pWLDisplay);
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        if (fds[0].revents & POLLIN)
+            wl_display_read_events(m_pWLDisplay);
+        else
+            wl_display_cancel_read(m_pWLDisplay);
+
+        if (wl_display_dispatch_pending(m_pWLDisplay) < 0 || (fds[0].revents & (POLLERR | POLLHUP)))
+            break;
+
+        if (fds[1].revents & POLLIN)
+            onRepeat();
+
+        if (fds[2].revents & POLLIN) {
+            signalfd_siginfo info;
+            if (read(m_iSignalFD, &info, sizeof(info)) == sizeof(info))
+                Debug::log(TRACE, "Got signal %u, exiting", info.ssi_signo);
+            finish(0);
+        }
+
+        if (m_bStartupPending)
+            finishStartup();
+
+        // a session that ended while dispatching has already closed the client this was polled for
+        if (fds[3].fd >= 0 && fds[3].fd == m_iClientFD && (fds[3].revents & (POLLIN | POLLHUP | POLLERR)))
+            onClientReadable();
+
+        if (fds[4].revents & POLLIN)
+            onDaemonConnection();
+
+        // out here, since sessions end from inside the listeners of the objects the teardown destroys
+        if (m_bTeardownPending)
+            teardownSession();
+    }
+
+    if (m_pWLDisplay) {
+        wl_display_disconnect(m_pWLDisplay);
+        m_pWLDisplay = nullptr;
+    }
+}
+
+// (removed) initCursorTheme — no custom cursor drawing
+
+void CHyprpicker::startSession(uint64_t startedAt) {
+    m_bSessionActive    = true;
+    m_iSessionStartedAt = startedAt;
+    m_szSessionOutput.clear();
+
     for (auto& m : m_vMonitors) {
         m_vLayerSurfaces.emplace_back(std::make_unique<CLayerSurface>(m.get()));
 
@@ -115,28 +280,216 @@ void CHyprpicker::init() {
         m->pLS      = m_vLayerSurfaces.back().get();
         m->initSCFrame();
     }
+}
 
-    wl_display_roundtrip(m_pWLDisplay);
+void CHyprpicker::endSession(int code) {
+    if (!m_bDaemon)
+        finish(code);
+
+    if (m_iClientFD >= 0)
+        NDaemon::reply(m_iClientFD, code, m_szSessionOutput);
+    m_iClientFD      = -1;
+    m_bSessionActive = false;
+    m_szSessionOutput.clear();
+    m_bStartupPending  = false;
+    m_bTeardownPending = true;
+}
+
+void CHyprpicker::teardownSession() {
+    m_bTeardownPending = false;
 
-    while (m_bRunning && wl_display_dispatch(m_pWLDisplay) != -1) {
-        //renderSurface(m_pLastSurface);
+    // the connection, globals, keymap, label font, worker pool and shm arena stay for the next pick
+    for (auto& m : m_vMonitors) {
+        m->pSCFrame.reset();
+        m->pLS = nullptr;
     }
 
-    if (m_pWLDisplay) {
-        wl_display_disconnect(m_pWLDisplay);
-        m_pWLDisplay = nullptr;
+    m_vLayerSurfaces.clear();
+    m_pLastSurface = nullptr;
+
+    // destroyed surfaces may never release their last buffers. Once the compositor has answered a sync sent after they went,
+    // nothing reads those slots anymore. A session started in the meantime may have retired buffers of its own, those wait for the next teardown.
+    if (m_pShmArena) {
+        m_pTeardownSync = makeShared<CCWlCallback>((wl_proxy*)wl_display_sync(m_pWLDisplay));
+        m_pTeardownSync->setDone([this](CCWlCallback* r, uint32_t data) { onTeardownSynced(); });
     }
+
+    // everything else starts over like in a fresh process
+    m_bCoordsInitialized = false;
+    m_vNudgeBufPx        = {0, 0};
+    m_keyLeft = m_keyRight = m_keyUp = m_keyDown = false;
+    updateRepeat();
+
+    m_multiBuffer.clear();
+    m_multiMode = false;
+    m_previewStack.clear();
+
+    m_iSampleRadius         = m_iSampleRadiusOption;
+    m_fSampleScroll         = 0.0;
+    m_zoomRadiusTargetSrcPx = ZOOM_RADIUS_DEFAULT;
+    m_zoomMagTarget         = ZOOM_MAG_DEFAULT;
+    m_zoomAnimInitialized   = false;
+    m_zoomMagBaseSet        = false;
+    m_apertureBaseSet       = false;
+    m_lockAperture          = false;
+    m_bAnimClockValid       = false;
+
+    wl_display_flush(m_pWLDisplay);
 }
 
-// (removed) initCursorTheme — no custom cursor drawing
+bool CHyprpicker::triggerDaemon() {
+    int         code = 0;
+    std::string output;
+    if (!NDaemon::trigger(NDaemon::socketPath(), code, output)) {
+        Debug::log(TRACE, "No daemon answered, picking here");
+        return false;
+    }
+
+    fputs(output.c_str(), stdout);
+    finish(code);
+    return true;
+}
+
+void CHyprpicker::onTeardownSynced() {
+    // destroys the callback whose listener this runs in, which is fine as long as nothing of it is touched after
+    m_pTeardownSync.reset();
+
+    if (!m_bSessionActive)
+        m_pShmArena->freeRetired();
+}
+
+void CHyprpicker::onDaemonConnection() {
+    const int FD = NDaemon::accept(m_iDaemonFD);
+    if (FD < 0)
+        return;
+
+    if (m_iClientFD >= 0 && m_bSessionActive) {
+        Debug::log(WARN, "Already picking for another client, refusing a trigger");
+        NDaemon::reply(FD, 1, "");
+        return;
+    }
+
+    // a client that connected but never asked for a pick would keep every later trigger out
+    if (m_iClientFD >= 0) {
+        Debug::log(WARN, "Dropping a client that never sent its request");
+        close(m_iClientFD);
+    }
+
+    m_iClientFD = FD;
+}
+
+void CHyprpicker::onClientReadable() {
+    if (m_bSessionActive) {
+        if (!NDaemon::connected(m_iClientFD)) {
+            Debug::log(LOG, "The client left, cancelling the pick");
+            endSession(2);
+        }
+        return;
+    }
+
+    if (!NDaemon::readRequest(m_iClientFD)) {
+        close(m_iClientFD);
+        m_iClientFD = -1;
+        return;
+    }
+
+    startSession(Stats::now());
+}
+
+void CHyprpicker::onFirstFrame(CLayerSurface* pSurface) {
+    Stats::record(Stats::STAGE_FIRST_FRAME, pSurface->m_pMonitor->name, m_iSessionStartedAt);
+
+    if (m_bStartupDone)
+        return;
+
+    // a slow output shouldn't hold up the others with work none of them needs to show up
+    if (std::ranges::all_of(m_vLayerSurfaces, [pSurface](const auto& ls) { return ls.get() == pSurface || ls->rendered; }))
+        m_bStartupPending = true;
+}
+
+void CHyprpicker::finishStartup() {
+    m_bStartupPending = false;
+    if (m_bStartupDone)
+        return;
+
+    m_bStartupDone = true;
+
+    // the first frames go out before any of this
+    wl_display_flush(m_pWLDisplay);
+
+    compileKeymap();
+
+    if (m_pCursorShapeMgr && m_pPointer && !m_pCursorShapeDevice)
+        m_pCursorShapeDevice = makeShared<CCWpCursorShapeDeviceV1>(m_pCursorShapeMgr->sendGetPointer(m_pPointer->resource()));
+
+    // resolving the font is the slow part of the first label, and the glyphs it needs are rasterized with it
+    if (!m_pLabelText && !m_bNoZoom && !m_bDisablePreview)
+        m_pLabelText = std::make_unique<CTextAtlas>("monospace", 18);
+}
+
+void CHyprpicker::compileKeymap() {
+    if (m_iKeymapFD < 0 || !m_pXKBContext)
+        return;
+
+    const int      FD   = m_iKeymapFD;
+    const uint32_t SIZE = m_iKeymapSize;
+    m_iKeymapFD         = -1;
+
+    const char* buf = (const char*)mmap(nullptr, SIZE, PROT_READ, MAP_SHARED, FD, 0);
+    close(FD);
+    if (buf == MAP_FAILED) {
+        Debug::log(ERR, "Failed to mmap xkb keymap: %d", errno);
+        return;
+    }
+
+    Stats::CTimer timer(Stats::STAGE_KEYMAP);
+
+    const auto    KEYMAP = xkb_keymap_new_from_buffer(m_pXKBContext, buf, SIZE - 1, XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+
+    munmap((void*)buf, SIZE);
+
+    if (!KEYMAP) {
+        Debug::log(ERR, "Failed to compile xkb keymap");
+        return;
+    }
+
+    const auto STATE = xkb_state_new(KEYMAP);
+    if (!STATE) {
+        Debug::log(ERR, "Failed to create xkb state");
+        xkb_keymap_unref(KEYMAP);
+        return;
+    }
+
+    if (m_pXKBState)
+        xkb_state_unref(m_pXKBState);
+    if (m_pXKBKeymap)
+        xkb_keymap_unref(m_pXKBKeymap);
+
+    m_pXKBKeymap = KEYMAP;
+    m_pXKBState  = STATE;
+
+    xkb_state_update_mask(m_pXKBState, m_iModsDepressed, m_iModsLatched, m_iModsLocked, 0, 0, m_iModsGroup);
+}
 
 void CHyprpicker::finish(int code) {
+    if (!m_szStatsPath.empty() && !Stats::write(m_szStatsPath))
+        Debug::log(ERR, "Couldn't write stats to %s", m_szStatsPath.c_str());
+
+    if (m_iDaemonFD >= 0) {
+        close(m_iDaemonFD);
+        unlink(m_szSocketPath.c_str());
+        m_iDaemonFD = -1;
+    }
+
     m_vLayerSurfaces.clear();
 
     if (m_pWLDisplay) {
         m_vLayerSurfaces.clear();
         m_vMonitors.clear();
+        m_pTeardownSync.reset();
+        m_pShmArena.reset();
         m_pCompositor.reset();
+        m_pSubcompositor.reset();
         m_pRegistry.reset();
         m_pSHM.reset();
         m_pLayerShell.reset();
@@ -148,6 +501,7 @@ void CHyprpicker::finish(int code) {
         m_pPointer.reset();
         m_pViewporter.reset();
         m_pFractionalMgr.reset();
+        m_pXDGOutputMgr.reset();
 
         wl_display_disconnect(m_pWLDisplay);
         m_pWLDisplay = nullptr;
@@ -156,50 +510,229 @@ void CHyprpicker::finish(int code) {
     exit(code);
 }
 
+void CHyprpicker::pickAt() {
+    Hyprpicker::CCapture capture;
+    if (!capture.good()) {
+        Debug::log(CRIT, "%s, can't proceed", capture.error().c_str());
+        finish(1);
+    }
+
+    Debug::log(TRACE, "Picking at %.0f, %.0f", m_vPickAt.x, m_vPickAt.y);
+
+    // only the logical pixel we want, the compositor hands us a frame of just that region (scale x scale pixels)
+    const auto FRAME = capture.captureRegion(m_vPickAt.x, m_vPickAt.y, 1, 1);
+    if (!FRAME) {
+        Debug::log(CRIT, "%s", capture.error().c_str());
+        finish(1);
+    }
+
+    const auto COL = FRAME->at(0, 0);
+    outputColor(CColor{.r = COL.r, .g = COL.g, .b = COL.b, .a = COL.a});
+
+    finish();
+}
+
+void CHyprpicker::sampleImage() {
+    // the image is converted like a capture, lazily, so only the tiles under the points are ever touched
+    std::string error;
+    const auto  FRAME = Hyprpicker::CFrame::fromFile(m_szImagePath, &error);
+    if (!FRAME) {
+        Debug::log(CRIT, "Couldn't load %s: %s", m_szImagePath.c_str(), error.c_str());
+        finish(1);
+    }
+
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    if (m_szPointsPath != "-") {
+        file.open(m_szPointsPath);
+        if (!file.good()) {
+            Debug::log(CRIT, "Couldn't open %s", m_szPointsPath.c_str());
+            finish(1);
+        }
+        in = &file;
+    }
+
+    if (m_bAutoCopy || m_bNotify) {
+        Debug::log(WARN, "--autocopy and --notify are ignored with --image");
+        m_bAutoCopy = false;
+        m_bNotify   = false;
+    }
+
+    // every line is a point "x y" or a rect "x y w h", separated by spaces or commas, and prints one color.
+    // Blank lines and everything after a # are skipped.
+    std::string line;
+    size_t      lineNo = 0;
+    while (std::getline(*in, line)) {
+        lineNo++;
+
+        if (const auto COMMENT = line.find('#'); COMMENT != std::string::npos)
+            line.resize(COMMENT);
+
+        int         values[4] = {0, 0, 0, 0};
+        size_t      count     = 0;
+        const char* it        = line.data();
+        const char* end       = line.data() + line.size();
+        bool        valid     = true;
+
+        while (it < end) {
+            if (*it == ' ' || *it == '\t' || *it == ',' || *it == '\r') {
+                it++;
+                continue;
+            }
+
+            if (count == 4) {
+                valid = false;
+                break;
+            }
+
+            const auto [ptr, ec] = std::from_chars(it, end, values[count]);
+            if (ec != std::errc{} || ptr == it) {
+                valid = false;
+                break;
+            }
+
+            it = ptr;
+            count++;
+        }
+
+        if (count == 0 && valid)
+            continue;
+
+        if (!valid || (count != 2 && count != 4) || (count == 4 && (values[2] <= 0 || values[3] <= 0))) {
+            Debug::log(CRIT, "%s:%zu: expected \"x y\" or \"x y w h\"", m_szPointsPath == "-" ? "stdin" : m_szPointsPath.c_str(), lineNo);
+            finish(1);
+        }
+
+        const auto COL = FRAME->average(values[0], values[1], count == 4 ? values[2] : 1, count == 4 ? values[3] : 1);
+        outputColor(CColor{.r = COL.r, .g = COL.g, .b = COL.b, .a = COL.a});
+    }
+
+    finish();
+}
+
+void CHyprpicker::watch() {
+    Hyprpicker::CCapture capture;
+    if (!capture.good()) {
+        Debug::log(CRIT, "%s, can't proceed", capture.error().c_str());
+        finish(1);
+    }
+
+    if (m_bAutoCopy || m_bNotify) {
+        Debug::log(WARN, "--autocopy and --notify are ignored with --watch");
+        m_bAutoCopy = false;
+        m_bNotify   = false;
+    }
+
+    // one period per tick, read() blocks in between. Ticks missed while a capture was slow are dropped, not caught up on.
+    const int TIMERFD = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (TIMERFD < 0) {
+        Debug::log(CRIT, "Couldn't create a timer: %s", strerror(errno));
+        finish(1);
+    }
+
+    const auto  PERIODNS = (long)std::max(1.0, 1000000000.0 / m_fWatchRate);
+    itimerspec  spec     = {};
+    spec.it_value        = {.tv_sec = 0, .tv_nsec = 1};
+    spec.it_interval     = {.tv_sec = PERIODNS / 1000000000L, .tv_nsec = PERIODNS % 1000000000L};
+    timerfd_settime(TIMERFD, 0, &spec, nullptr);
+
+    // the last m_iWatchSmooth samples, and their running sums
+    std::vector<Hyprpicker::SColor> window(m_iWatchSmooth);
+    uint64_t                        sum[4] = {0, 0, 0, 0};
+    size_t                          count = 0, next = 0;
+    std::string                     lastText;
+
+    Debug::log(TRACE, "Watching %.0fx%.0f at %.0f, %.0f, %g times a second", m_watchBox.w, m_watchBox.h, m_watchBox.x, m_watchBox.y, m_fWatchRate);
+
+    while (true) {
+        uint64_t expirations = 0;
+        if (read(TIMERFD, &expirations, sizeof(expirations)) < 0) {
+            if (errno == EINTR)
+                continue;
+            Debug::log(CRIT, "Couldn't read the timer: %s", strerror(errno));
+            finish(1);
+        }
+
+        // the region is captured at the output's pixel resolution, into the same small buffer every time
+        const auto FRAME = capture.recaptureRegion(m_watchBox.x, m_watchBox.y, m_watchBox.w, m_watchBox.h);
+        if (!FRAME) {
+            if (!capture.good()) {
+                Debug::log(CRIT, "%s", capture.error().c_str());
+                finish(1);
+            }
+
+            // e.g. the output is off, the next tick tries again
+            Debug::log(TRACE, "Skipping a sample: %s", capture.error().c_str());
+            continue;
+        }
+
+        const auto SAMPLE = FRAME->average(0, 0, FRAME->width(), FRAME->height());
+        const auto OLD    = window[next];
+        sum[0] += SAMPLE.r;
+        sum[1] += SAMPLE.g;
+        sum[2] += SAMPLE.b;
+        sum[3] += SAMPLE.a;
+        if (count == window.size()) {
+            sum[0] -= OLD.r;
+            sum[1] -= OLD.g;
+            sum[2] -= OLD.b;
+            sum[3] -= OLD.a;
+        } else
+            count++;
+        window[next] = SAMPLE;
+        next         = (next + 1) % window.size();
+
+        const auto  AVG  = [&](size_t c) { return (uint8_t)((sum[c] + count / 2) / count); };
+        const auto  TEXT = colorText(CColor{.r = AVG(0), .g = AVG(1), .b = AVG(2), .a = AVG(3)});
+
+        if (m_bWatchChanges && TEXT == lastText)
+            continue;
+        lastText = TEXT;
+
+        // whoever reads the stream gets every line as soon as it's sampled
+        printOutput(std::format("{:%FT%T}Z {}", std::chrono::floor<std::chrono::milliseconds>(std::chrono::system_clock::now()), TEXT));
+        std::cout.flush();
+    }
+}
+
 void CHyprpicker::recheckACK() {
     for (auto& ls : m_vLayerSurfaces) {
-        if ((ls->wantsACK || ls->wantsReload) && ls->screenBuffer) {
+        if ((ls->wantsACK || ls->wantsReload) && (ls->captureBuffer || ls->screenBuffer)) {
             if (ls->wantsACK)
                 ls->pLayerSurface->sendAckConfigure(ls->ACKSerial);
             ls->wantsACK    = false;
             ls->wantsReload = false;
 
             const auto MONITORSIZE =
-                (ls->screenBuffer && !g_pHyprpicker->m_bNoFractional ? ls->m_pMonitor->size * ls->fractionalScale : ls->m_pMonitor->size * ls->m_pMonitor->scale).round();
+                (!g_pHyprpicker->m_bNoFractional ? ls->m_pMonitor->size * ls->fractionalScale : ls->m_pMonitor->size * ls->m_pMonitor->scale).round();
+
+            ls->canvasSize = MONITORSIZE;
 
-            if (!ls->buffers[0] || ls->buffers[0]->pixelSize != MONITORSIZE) {
+            // with --subsurface nothing is ever rendered at full size
+            if (!m_bSubsurface && (ls->swapchain.empty() || ls->swapchain.size() != MONITORSIZE)) {
                 Debug::log(TRACE, "making new buffers: size changed to %.0fx%.0f", MONITORSIZE.x, MONITORSIZE.y);
-                ls->buffers[0] = makeShared<SPoolBuffer>(MONITORSIZE, WL_SHM_FORMAT_ARGB8888, MONITORSIZE.x * 4);
-                ls->buffers[1] = makeShared<SPoolBuffer>(MONITORSIZE, WL_SHM_FORMAT_ARGB8888, MONITORSIZE.x * 4);
+                ls->swapchain.resize(MONITORSIZE);
             }
 
-            
+            // only this monitor changed, the others keep going on their own
+            ls->markDirty();
         }
     }
-
-    markDirty();
 }
 
 void CHyprpicker::markDirty() {
     for (auto& ls : m_vLayerSurfaces) {
-        if (ls->frameCallback)
-            continue;
-
         ls->markDirty();
     }
 }
 
-SP<SPoolBuffer> CHyprpicker::getBufferForLS(CLayerSurface* pLS) {
-    SP<SPoolBuffer> returns = nullptr;
-
-    for (auto i = 0; i < 2; ++i) {
-        if (!pLS->buffers[i] || pLS->buffers[i]->busy)
-            continue;
-
-        returns = pLS->buffers[i];
-    }
+void CHyprpicker::markDirty(CLayerSurface* pSurface) {
+    if (pSurface)
+        pSurface->markDirty();
+}
 
-    return returns;
+SP<SPoolBuffer> CHyprpicker::getBufferForLS(CLayerSurface* pLS) {
+    return pLS->swapchain.acquire();
 }
 
 bool CHyprpicker::setCloexec(const int& FD) {
@@ -245,120 +778,61 @@ int CHyprpicker::createPoolFile(size_t size, std::string& name) {
     return FD;
 }
 
-void CHyprpicker::convertBuffer(SP<SPoolBuffer> pBuffer) {
-    switch (pBuffer->format) {
-        case WL_SHM_FORMAT_ARGB8888:
-        case WL_SHM_FORMAT_XRGB8888: break;
-        case WL_SHM_FORMAT_ABGR8888:
-        case WL_SHM_FORMAT_XBGR8888: {
-            uint8_t* data = (uint8_t*)pBuffer->data;
-
-            for (int y = 0; y < pBuffer->pixelSize.y; ++y) {
-                for (int x = 0; x < pBuffer->pixelSize.x; ++x) {
-                    struct SPixel {
-                        // little-endian ARGB
-                        unsigned char blue;
-                        unsigned char green;
-                        unsigned char red;
-                        unsigned char alpha;
-                    }* px = (struct SPixel*)(data + (static_cast<ptrdiff_t>(y * (int)pBuffer->pixelSize.x * 4)) + (static_cast<ptrdiff_t>(x * 4)));
-
-                    std::swap(px->red, px->blue);
-                }
-            }
-        } break;
-        case WL_SHM_FORMAT_XRGB2101010:
-        case WL_SHM_FORMAT_XBGR2101010: {
-            uint8_t*   data = (uint8_t*)pBuffer->data;
+// the library's name for an output mode
+static Hyprpicker::eFormat libFormat(eOutputMode mode) {
+    switch (mode) {
+        case OUTPUT_CMYK: return Hyprpicker::FORMAT_CMYK;
+        case OUTPUT_HEX: return Hyprpicker::FORMAT_HEX;
+        case OUTPUT_RGB: return Hyprpicker::FORMAT_RGB;
+        case OUTPUT_HSL: return Hyprpicker::FORMAT_HSL;
+        case OUTPUT_HSV: return Hyprpicker::FORMAT_HSV;
+    }
 
-            const bool FLIP = pBuffer->format == WL_SHM_FORMAT_XBGR2101010;
+    return Hyprpicker::FORMAT_HEX;
+}
 
-            for (int y = 0; y < pBuffer->pixelSize.y; ++y) {
-                for (int x = 0; x < pBuffer->pixelSize.x; ++x) {
-                    uint32_t* px = (uint32_t*)(data + (static_cast<ptrdiff_t>(y * (int)pBuffer->pixelSize.x * 4)) + (static_cast<ptrdiff_t>(x * 4)));
+// the buffer's pixels as a resample target
+static NResample::SImage bufferImage(const SP<SPoolBuffer>& buffer) {
+    return {.data = (uint8_t*)buffer->data, .width = (uint32_t)buffer->pixelSize.x, .height = (uint32_t)buffer->pixelSize.y, .stride = buffer->stride};
+}
 
-                    // conv to 8 bit
-                    uint8_t R = (uint8_t)std::round((255.0 * (((*px) & 0b00000000000000000000001111111111) >> 0) / 1023.0));
-                    uint8_t G = (uint8_t)std::round((255.0 * (((*px) & 0b00000000000011111111110000000000) >> 10) / 1023.0));
-                    uint8_t B = (uint8_t)std::round((255.0 * (((*px) & 0b00111111111100000000000000000000) >> 20) / 1023.0));
-                    uint8_t A = (uint8_t)std::round((255.0 * (((*px) & 0b11000000000000000000000000000000) >> 30) / 3.0));
+void CHyprpicker::renderSurface(CLayerSurface* pSurface, bool forceInactive) {
+    if (!pSurface->screenBuffer)
+        return;
 
-                    // write 8-bit values
-                    *px = ((FLIP ? B : R) << 0) + (G << 8) + ((FLIP ? R : B) << 16) + (A << 24);
-                }
-            }
-        } break;
-        default: {
-            Debug::log(CRIT, "Unsupported format %i", pBuffer->format);
-        }
-            g_pHyprpicker->finish(1);
-    }
-}
+    Stats::CTimer timer(Stats::STAGE_RENDER, pSurface->m_pMonitor->name);
 
-// Mallocs a new buffer, which needs to be free'd!
-void* CHyprpicker::convert24To32Buffer(SP<SPoolBuffer> pBuffer) {
-    uint8_t* newBuffer       = (uint8_t*)malloc((size_t)pBuffer->pixelSize.x * pBuffer->pixelSize.y * 4);
-    int      newBufferStride = pBuffer->pixelSize.x * 4;
-    uint8_t* oldBuffer       = (uint8_t*)pBuffer->data;
-
-    switch (pBuffer->format) {
-        case WL_SHM_FORMAT_BGR888: {
-            for (int y = 0; y < pBuffer->pixelSize.y; ++y) {
-                for (int x = 0; x < pBuffer->pixelSize.x; ++x) {
-                    struct SPixel3 {
-                        // little-endian RGB
-                        unsigned char blue;
-                        unsigned char green;
-                        unsigned char red;
-                    }* srcPx = (struct SPixel3*)(oldBuffer + (static_cast<size_t>(y * pBuffer->stride)) + (static_cast<ptrdiff_t>(x * 3)));
-                    struct SPixel4 {
-                        // little-endian ARGB
-                        unsigned char blue;
-                        unsigned char green;
-                        unsigned char red;
-                        unsigned char alpha;
-                    }* dstPx = (struct SPixel4*)(newBuffer + (static_cast<ptrdiff_t>(y * newBufferStride)) + (static_cast<ptrdiff_t>(x * 4)));
-                    *dstPx   = {.blue = srcPx->red, .green = srcPx->green, .red = srcPx->blue, .alpha = 0xFF};
-                }
-            }
-        } break;
-        case WL_SHM_FORMAT_RGB888: {
-            for (int y = 0; y < pBuffer->pixelSize.y; ++y) {
-                for (int x = 0; x < pBuffer->pixelSize.x; ++x) {
-                    struct SPixel3 {
-                        // big-endian RGB
-                        unsigned char red;
-                        unsigned char green;
-                        unsigned char blue;
-                    }* srcPx = (struct SPixel3*)(oldBuffer + (y * pBuffer->stride) + (x * 3));
-                    struct SPixel4 {
-                        // big-endian ARGB
-                        unsigned char alpha;
-                        unsigned char red;
-                        unsigned char green;
-                        unsigned char blue;
-                    }* dstPx = (struct SPixel4*)(newBuffer + (y * newBufferStride) + (x * 4));
-                    *dstPx   = {.alpha = 0xFF, .red = srcPx->red, .green = srcPx->green, .blue = srcPx->blue};
-                }
-            }
-        } break;
-        default: {
-            Debug::log(CRIT, "Unsupported format for 24bit buffer %i", pBuffer->format);
-        }
-            g_pHyprpicker->finish(1);
+    // --live: the monitor under the pointer always has a capture of the lens neighbourhood in flight, each render asks for the next one
+    if (m_bLive && pSurface == m_pLastSurface && m_bCoordsInitialized && !pSurface->liveFrame)
+        pSurface->requestLiveFrame(lensSourceBox(pSurface));
+
+    if (m_bSubsurface) {
+        renderLens(pSurface);
+        return;
     }
-    return newBuffer;
-}
 
-void CHyprpicker::renderSurface(CLayerSurface* pSurface, bool forceInactive) {
     const auto PBUFFER = getBufferForLS(pSurface);
 
-    if (!PBUFFER || !pSurface->screenBuffer) {
-        // Spammy log, doesn't matter.
-        // Debug::log(ERR, PBUFFER ? "renderSurface: pSurface->screenBuffer null" : "renderSurface: PBUFFER null");
+    if (!PBUFFER) {
+        // the swapchain logs and counts the drop, try again once the compositor gives a buffer back
+        pSurface->renderPending = !pSurface->swapchain.empty();
         return;
     }
 
+    pSurface->renderPending = false;
+    // an unfinished animation sets this again in renderOverlay
+    pSurface->dirty = false;
+
+    const bool ACTIVE = pSurface == m_pLastSurface && !forceInactive && m_bCoordsInitialized;
+    const auto CONTENT =
+        !m_bCoordsInitialized ? BUFFER_CONTENT_NONE :
+                                (ACTIVE ? (m_bLive ? BUFFER_CONTENT_LIVE : BUFFER_CONTENT_ACTIVE) : (!m_bRenderInactive || m_bLive ? BUFFER_CONTENT_CLEAR : BUFFER_CONTENT_FROZEN));
+    // unless the buffer holds the same kind of frame on the same frozen screen, everything is repainted. Otherwise the frozen screen is
+    // intact outside of the old overlay, so only that is restored before the new overlay goes on top.
+    const bool FULLREPAINT = CONTENT == BUFFER_CONTENT_NONE || PBUFFER->content != CONTENT || PBUFFER->contentSerial != pSurface->screenBufferSerial;
+    // buffer pixels the new overlay covers
+    CRegion    overlay;
+
     PBUFFER->surface =
         cairo_image_surface_create_for_data((unsigned char*)PBUFFER->data, CAIRO_FORMAT_ARGB32, PBUFFER->pixelSize.x, PBUFFER->pixelSize.y, PBUFFER->pixelSize.x * 4);
 
@@ -368,416 +842,353 @@ void CHyprpicker::renderSurface(CLayerSurface* pSurface, bool forceInactive) {
 
     cairo_save(PCAIRO);
 
-    cairo_set_source_rgba(PCAIRO, 0, 0, 0, 0);
-
-    cairo_rectangle(PCAIRO, 0, 0, PBUFFER->pixelSize.x, PBUFFER->pixelSize.y);
-    cairo_fill(PCAIRO);
+    if (FULLREPAINT) {
+        cairo_set_source_rgba(PCAIRO, 0, 0, 0, 0);
 
-    if (pSurface == m_pLastSurface && !forceInactive && m_bCoordsInitialized) {
-        const auto SCALEBUFS      = pSurface->screenBuffer->pixelSize / PBUFFER->pixelSize;
-        const auto MOUSECOORDSABS = m_vLastCoords.floor() / pSurface->m_pMonitor->size;
-        const auto CLICKPOS       = MOUSECOORDSABS * PBUFFER->pixelSize;
+        cairo_rectangle(PCAIRO, 0, 0, PBUFFER->pixelSize.x, PBUFFER->pixelSize.y);
+        cairo_fill(PCAIRO);
+    }
 
-        Debug::log(TRACE, "renderSurface: scalebufs %.2fx%.2f", SCALEBUFS.x, SCALEBUFS.y);
+    if (ACTIVE && m_bLive) {
+        // the real screen shows through, only what the old overlay covered has to go
+        cairo_set_operator(PCAIRO, CAIRO_OPERATOR_SOURCE);
+        cairo_set_source_rgba(PCAIRO, 0, 0, 0, 0);
+        if (FULLREPAINT)
+            cairo_rectangle(PCAIRO, 0, 0, PBUFFER->pixelSize.x, PBUFFER->pixelSize.y);
+        else {
+            for (const auto& RECT : PBUFFER->contentOverlay.getRects()) {
+                cairo_rectangle(PCAIRO, RECT.x1, RECT.y1, RECT.x2 - RECT.x1, RECT.y2 - RECT.y1);
+            }
+        }
+        cairo_fill(PCAIRO);
 
-        const auto PATTERNPRE = cairo_pattern_create_for_surface(pSurface->screenBuffer->surface);
-        cairo_pattern_set_filter(PATTERNPRE, CAIRO_FILTER_BILINEAR);
-        cairo_matrix_t matrixPre;
-        cairo_matrix_init_identity(&matrixPre);
-        cairo_matrix_scale(&matrixPre, SCALEBUFS.x, SCALEBUFS.y);
-        cairo_pattern_set_matrix(PATTERNPRE, &matrixPre);
-        cairo_set_source(PCAIRO, PATTERNPRE);
-        cairo_paint(PCAIRO);
+        cairo_restore(PCAIRO);
+        if (!m_bNoZoom)
+            renderOverlay(pSurface, PCAIRO, PBUFFER->pixelSize, overlay);
+    } else if (ACTIVE) {
+        // the frozen screen outside of the overlay is already in the buffer unless it's a full repaint
+        cairo_surface_flush(PBUFFER->surface);
+        {
+            Stats::CTimer background(Stats::STAGE_BACKGROUND, pSurface->m_pMonitor->name);
+            NResample::copy(pSurface->displayBackground(PBUFFER->pixelSize), bufferImage(PBUFFER), FULLREPAINT ? nullptr : &PBUFFER->contentOverlay, m_pWorkerPool.get());
+        }
+        cairo_surface_mark_dirty(PBUFFER->surface);
 
+        cairo_restore(PCAIRO);
+        if (!m_bNoZoom)
+            renderOverlay(pSurface, PCAIRO, PBUFFER->pixelSize, overlay);
+    } else if (CONTENT == BUFFER_CONTENT_CLEAR) {
+        if (FULLREPAINT) {
+            cairo_set_operator(PCAIRO, CAIRO_OPERATOR_SOURCE);
+            cairo_set_source_rgba(PCAIRO, 0, 0, 0, 0);
+            cairo_rectangle(PCAIRO, 0, 0, PBUFFER->pixelSize.x, PBUFFER->pixelSize.y);
+            cairo_fill(PCAIRO);
+        }
+    } else if (CONTENT == BUFFER_CONTENT_FROZEN && FULLREPAINT) {
         cairo_surface_flush(PBUFFER->surface);
+        {
+            Stats::CTimer background(Stats::STAGE_BACKGROUND, pSurface->m_pMonitor->name);
+            NResample::copy(pSurface->displayBackground(PBUFFER->pixelSize), bufferImage(PBUFFER), nullptr, m_pWorkerPool.get());
+        }
+        cairo_surface_mark_dirty(PBUFFER->surface);
+    }
 
-        cairo_pattern_destroy(PATTERNPRE);
+    overlay.intersect(0, 0, PBUFFER->pixelSize.x, PBUFFER->pixelSize.y);
 
-        // we draw the preview like this
-        //
-        //     200px        ZOOM: 10x
-        // | --------- |
-        // |           |
-        // |     x     | 200px
-        // |           |
-        // | --------- |
-        //
-        // (hex code here)
+    PBUFFER->content       = CONTENT;
+    PBUFFER->contentSerial = pSurface->screenBufferSerial;
+    PBUFFER->contentOverlay.set(overlay);
 
-        cairo_restore(PCAIRO);
-        if (!m_bNoZoom) {
-            cairo_save(PCAIRO);
-
-            // Compute center position with keyboard nudge applied (in buffer pixels)
-            const auto BASEPOSBUF = CLICKPOS / PBUFFER->pixelSize * pSurface->screenBuffer->pixelSize;
-            Vector2D    centerBuf = BASEPOSBUF + m_vNudgeBufPx;
-            // Clamp to valid pixel range
-            centerBuf.x           = std::clamp(centerBuf.x, 0.0, pSurface->screenBuffer->pixelSize.x - 1.0);
-            centerBuf.y           = std::clamp(centerBuf.y, 0.0, pSurface->screenBuffer->pixelSize.y - 1.0);
-
-            // UI center should move with the nudge as well. Convert the nudge (screenBuffer pixels)
-            // into this surface's buffer coordinates and offset the on-screen UI accordingly.
-            const auto SCALEBUFS_INV = Vector2D{1.0 / SCALEBUFS.x, 1.0 / SCALEBUFS.y};
-            Vector2D    uiCenter     = CLICKPOS + (m_vNudgeBufPx * SCALEBUFS_INV);
-            uiCenter.x               = std::clamp(uiCenter.x, 0.0, PBUFFER->pixelSize.x - 1.0);
-            uiCenter.y               = std::clamp(uiCenter.y, 0.0, PBUFFER->pixelSize.y - 1.0);
-
-            const auto PIXCOLOR = getColorFromPixel(pSurface, centerBuf);
-            cairo_set_source_rgba(PCAIRO, PIXCOLOR.r / 255.f, PIXCOLOR.g / 255.f, PIXCOLOR.b / 255.f, PIXCOLOR.a / 255.f);
-
-            cairo_scale(PCAIRO, 1, 1);
-
-            // Update spring animations for zoom radius and magnification
-            {
-                using namespace std::chrono;
-                const auto now = steady_clock::now();
-                if (!m_zoomAnimInitialized) {
-                    m_zoomAnimInitialized = true;
-                    m_zoomLastTick        = now;
-                    m_zoomRadiusCurrentSrcPx = m_zoomRadiusTargetSrcPx;
-                    m_zoomRadiusVel          = 0.0;
-                    m_zoomMagCurrent         = m_zoomMagTarget;
-                    m_zoomMagVel             = 0.0;
-                    if (!m_zoomMagBaseSet) {
-                        m_zoomMagBase    = m_zoomMagTarget;
-                        m_zoomMagBaseSet = true;
-                    }
-                    // Aperture will be preserved on ALT zoom using current values at the event
-                }
-                const double dt = duration<double>(now - m_zoomLastTick).count();
-                m_zoomLastTick  = now;
-                if (dt > 0.0) {
-                    // Snappier critically-damped spring
-                    const double k    = SPRING_K;
-                    const double zeta = SPRING_ZETA;
-                    const double c    = 2.0 * std::sqrt(k) * zeta;
-                    // Radius
-                    {
-                        const double x = m_zoomRadiusCurrentSrcPx - m_zoomRadiusTargetSrcPx;
-                        const double a = (-k * x) - (c * m_zoomRadiusVel);
-                        m_zoomRadiusVel += a * dt;
-                        m_zoomRadiusCurrentSrcPx += m_zoomRadiusVel * dt;
-                        // Snap when very close to avoid jitter
-                        if (std::abs(m_zoomRadiusCurrentSrcPx - m_zoomRadiusTargetSrcPx) < 0.01 && std::abs(m_zoomRadiusVel) < 0.01) {
-                            m_zoomRadiusCurrentSrcPx = m_zoomRadiusTargetSrcPx;
-                            m_zoomRadiusVel          = 0.0;
-                        }
-                    }
-                    // Magnification
-                    {
-                        const double xM = m_zoomMagCurrent - m_zoomMagTarget;
-                        const double aM = (-k * xM) - (c * m_zoomMagVel);
-                        m_zoomMagVel += aM * dt;
-                        m_zoomMagCurrent += m_zoomMagVel * dt;
-                        if (std::abs(m_zoomMagCurrent - m_zoomMagTarget) < 0.01 && std::abs(m_zoomMagVel) < 0.01) {
-                            m_zoomMagCurrent = m_zoomMagTarget;
-                            m_zoomMagVel     = 0.0;
-                        }
-                    }
-                    // If locking aperture (ALT zoom transition), force radius to keep UI circle constant
-                    if (m_lockAperture) {
-                        const double targetR = (m_zoomMagCurrent > 0.01) ? (m_lockedAperture / m_zoomMagCurrent) : m_zoomRadiusCurrentSrcPx;
-                        m_zoomRadiusCurrentSrcPx = targetR;
-                        m_zoomRadiusTargetSrcPx  = targetR;
-                        m_zoomRadiusVel          = 0.0;
-                        // Release the lock once magnification settles at target
-                        if (std::abs(m_zoomMagCurrent - m_zoomMagTarget) < 0.01 && std::abs(m_zoomMagVel) < 0.01)
-                            m_lockAperture = false;
-                    }
-                }
-            }
+    pSurface->sendFrame(PBUFFER);
+    cairo_destroy(PCAIRO);
+    cairo_surface_destroy(PBUFFER->surface);
 
-            // Keep the zoom circle centered at the (possibly nudged) UI center
-            const double cellWForRadius = m_zoomMagCurrent / SCALEBUFS.x;
-            const double zoomRadiusUI   = m_zoomRadiusCurrentSrcPx * cellWForRadius;
-            const double onePxUI        = 1.0 / std::min(SCALEBUFS.x, SCALEBUFS.y);
-            const double outerRadiusUI  = zoomRadiusUI + RING_OFFSET_UI_PX * onePxUI; // thin border ring
-            cairo_arc(PCAIRO, uiCenter.x, uiCenter.y, outerRadiusUI, 0, 2 * M_PI);
-            cairo_clip(PCAIRO);
+    PBUFFER->cairo   = nullptr;
+    PBUFFER->surface = nullptr;
 
-            cairo_fill(PCAIRO);
-            cairo_paint(PCAIRO);
-
-            cairo_surface_flush(PBUFFER->surface);
-
-            cairo_restore(PCAIRO);
-            cairo_save(PCAIRO);
-
-            const auto PATTERN = cairo_pattern_create_for_surface(pSurface->screenBuffer->surface);
-            cairo_pattern_set_filter(PATTERN, CAIRO_FILTER_NEAREST);
-            cairo_matrix_t matrix;
-            cairo_matrix_init_identity(&matrix);
-            cairo_matrix_translate(&matrix, centerBuf.x + 0.5f, centerBuf.y + 0.5f);
-            const double invMag = 1.0 / std::max(0.01, m_zoomMagCurrent);
-            cairo_matrix_scale(&matrix, invMag, invMag);
-            cairo_matrix_translate(&matrix, (-centerBuf.x / SCALEBUFS.x) - 0.5f, (-centerBuf.y / SCALEBUFS.y) - 0.5f);
-            cairo_pattern_set_matrix(PATTERN, &matrix);
-            cairo_set_source(PCAIRO, PATTERN);
-            // Keep the zoom circle centered at the (possibly nudged) UI center
-            const double zoomRadius = zoomRadiusUI;
-            cairo_arc(PCAIRO, uiCenter.x, uiCenter.y, zoomRadius, 0, 2 * M_PI);
-            cairo_clip(PCAIRO);
-            cairo_paint(PCAIRO);
-
-            // Draw a faint pixel grid overlay aligned to the source pixels
-            // One source pixel maps to m_zoomMagCurrent in the zoom (scale 1/mag above)
-            {
-                const double cellW = m_zoomMagCurrent / SCALEBUFS.x;
-                const double cellH = m_zoomMagCurrent / SCALEBUFS.y;
-
-                // Snap visual grid to the nearest source pixel so it stays static
-                const double pxX           = std::floor(centerBuf.x);
-                const double pxY           = std::floor(centerBuf.y);
-                const double centerBoundX  = pxX + 0.5; // center of the pixel under the cursor
-                const double centerBoundY  = pxY + 0.5;
-
-                // Compute visible boundary index range around the zoom circle (boundaries at integers)
-                const double minVXSrc = centerBoundX - (zoomRadius / cellW);
-                const double maxVXSrc = centerBoundX + (zoomRadius / cellW);
-                const long   vStart   = (long)std::floor(minVXSrc);
-                const long   vEnd     = (long)std::ceil(maxVXSrc);
-
-                const double minVYSrc = centerBoundY - (zoomRadius / cellH);
-                const double maxVYSrc = centerBoundY + (zoomRadius / cellH);
-                const long   hStart   = (long)std::floor(minVYSrc);
-                const long   hEnd     = (long)std::ceil(maxVYSrc);
-
-                cairo_save(PCAIRO);
-                // Very faint lines; hairline width in UI pixels
-                cairo_set_antialias(PCAIRO, CAIRO_ANTIALIAS_NONE);
-                cairo_set_source_rgba(PCAIRO, 1.0, 1.0, 1.0, GRID_ALPHA);
-                cairo_set_line_width(PCAIRO, onePxUI);
-
-                // Vertical lines (at integer x boundaries)
-                for (long j = vStart; j <= vEnd; ++j) {
-                    const double srcX  = (double)j;
-                    const double drawX = uiCenter.x + (srcX - centerBoundX) * cellW;
-                    cairo_move_to(PCAIRO, drawX, uiCenter.y - zoomRadius);
-                    cairo_line_to(PCAIRO, drawX, uiCenter.y + zoomRadius);
-                }
+    pSurface->rendered = true;
+}
 
-                // Horizontal lines (at integer y boundaries)
-                for (long i = hStart; i <= hEnd; ++i) {
-                    const double srcY  = (double)i;
-                    const double drawY = uiCenter.y + (srcY - centerBoundY) * cellH;
-                    cairo_move_to(PCAIRO, uiCenter.x - zoomRadius, drawY);
-                    cairo_line_to(PCAIRO, uiCenter.x + zoomRadius, drawY);
-                }
+void CHyprpicker::renderLens(CLayerSurface* pSurface) {
+    if (pSurface->canvasSize.x < 1 || pSurface->canvasSize.y < 1)
+        return;
 
-                cairo_stroke(PCAIRO);
-
-                // Highlight the central pixel with a solid white border, fixed at center
-                cairo_set_source_rgba(PCAIRO, 1.0, 1.0, 1.0, 1.0);
-                cairo_set_line_width(PCAIRO, 2.0 * onePxUI);
-                cairo_set_line_join(PCAIRO, CAIRO_LINE_JOIN_ROUND);
-                const double leftUI   = uiCenter.x - 0.5 * cellW;
-                const double rightUI  = uiCenter.x + 0.5 * cellW;
-                const double topUI    = uiCenter.y - 0.5 * cellH;
-                const double bottomUI = uiCenter.y + 0.5 * cellH;
-                cairo_rectangle(PCAIRO, leftUI, topUI, rightUI - leftUI, bottomUI - topUI);
-                cairo_stroke(PCAIRO);
-                cairo_restore(PCAIRO);
-            }
+    Stats::CTimer timer(Stats::STAGE_RENDER, pSurface->m_pMonitor->name);
 
-            // Draw ring border + shadow now (outside any clip) so labels can render on top
-            {
-                cairo_reset_clip(PCAIRO);
-                cairo_save(PCAIRO);
-                cairo_set_antialias(PCAIRO, CAIRO_ANTIALIAS_DEFAULT);
-                cairo_set_line_join(PCAIRO, CAIRO_LINE_JOIN_ROUND);
-
-                const double ringOuterRad = zoomRadiusUI + RING_OFFSET_UI_PX * onePxUI; // aligns with thin ring offset
-
-                // Shadow: soft halo outside the ring
-                cairo_set_source_rgba(PCAIRO, 0.0, 0.0, 0.0, RING_SHADOW_ALPHA);
-                cairo_set_line_width(PCAIRO, RING_SHADOW_PX * onePxUI);
-                cairo_new_path(PCAIRO);
-                cairo_arc(PCAIRO, uiCenter.x, uiCenter.y, ringOuterRad + 1.0 * onePxUI, 0, 2 * M_PI);
-                cairo_stroke(PCAIRO);
-
-                // White border: crisp 2px stroke around the ring
-                cairo_set_source_rgba(PCAIRO, 1.0, 1.0, 1.0, 1.0);
-                cairo_set_line_width(PCAIRO, RING_BORDER_PX * onePxUI);
-                cairo_new_path(PCAIRO);
-                cairo_arc(PCAIRO, uiCenter.x, uiCenter.y, ringOuterRad, 0, 2 * M_PI);
-                cairo_stroke(PCAIRO);
-
-                cairo_restore(PCAIRO);
-            }
+    const bool    ACTIVE = pSurface == m_pLastSurface && m_bCoordsInitialized;
 
-            if (!m_bDisablePreview) {
-                // Update UI animation dt for stacked labels
-                using namespace std::chrono;
-                const auto nowUI = steady_clock::now();
-                if (!m_uiAnimInitialized) {
-                    m_uiAnimInitialized = true;
-                    m_uiAnimLastTick    = nowUI;
-                }
-                double dtUI = duration<double>(nowUI - m_uiAnimLastTick).count();
-                m_uiAnimLastTick = nowUI;
-                // Decide label stack direction: keep below the circle UI (positive Y), unless too close to bottom
-                const bool nearBottomForDir = (uiCenter.y > (PBUFFER->pixelSize.y - 80));
-                const bool placeAboveDir    = nearBottomForDir; // only go above when near bottom edge
-                const double dirSign        = placeAboveDir ? -1.0 : 1.0; // negative Y is up
-                // Update target offsets every frame so stack follows circle (newest closest to active)
-                const size_t nStack = m_previewStack.size();
-                const double stackStep = LABEL_HEIGHT_UI_PX + LABEL_STACK_MARGIN_UI_PX;
-                for (size_t i = 0; i < nStack; ++i)
-                    m_previewStack[i].offsetTargetUI = dirSign * static_cast<double>(nStack - i) * stackStep;
-                // Animate stacked label offsets towards targets
-                if (dtUI > 0.0) {
-                    const double alpha = std::clamp(dtUI * LABEL_ANIM_SPEED, 0.0, 1.0);
-                    for (auto& item : m_previewStack)
-                        item.offsetCurrentUI += (item.offsetTargetUI - item.offsetCurrentUI) * alpha;
-                }
-                const auto  currentColor = getColorFromPixel(pSurface, centerBuf);
-                std::string previewBuffer;
-                switch (m_bSelectedOutputMode) {
-                    case OUTPUT_HEX: {
-                        previewBuffer = std::format("#{:02X}{:02X}{:02X}", currentColor.r, currentColor.g, currentColor.b);
-                        if (m_bUseLowerCase)
-                            for (auto& c : previewBuffer)
-                                c = std::tolower(c);
-                        break;
-                    };
-                    case OUTPUT_RGB: {
-                        previewBuffer = std::format("{} {} {}", currentColor.r, currentColor.g, currentColor.b);
-                        break;
-                    };
-                    case OUTPUT_HSL: {
-                        float h, s, l;
-                        currentColor.getHSL(h, s, l);
-                        previewBuffer = std::format("{} {}% {}%", h, s, l);
-                        break;
-                    };
-                    case OUTPUT_HSV: {
-                        float h, s, v;
-                        currentColor.getHSV(h, s, v);
-                        previewBuffer = std::format("{} {}% {}%", h, s, v);
-                        break;
-                    };
-                    case OUTPUT_CMYK: {
-                        float c, m, y, k;
-                        currentColor.getCMYK(c, m, y, k);
-                        previewBuffer = std::format("{}% {}% {}% {}%", c, m, y, k);
-                        break;
-                    };
-                };
-                cairo_set_source_rgba(PCAIRO, 0.0, 0.0, 0.0, 0.75);
-
-                double x, y;
-                const double height = LABEL_HEIGHT_UI_PX, radius = 6;
-                double width = 8 + (11 * previewBuffer.length());
-
-                const bool nearTop    = (uiCenter.y < 60.0);
-                const bool nearRight  = (uiCenter.x > (PBUFFER->pixelSize.x - 100));
-                const bool nearBottom = (uiCenter.y > (PBUFFER->pixelSize.y - 50));
-                const bool placeAbove = nearBottom; // keep below unless too close to bottom
-                if (placeAbove) {
-                    if (nearRight) { x = uiCenter.x - 80; y = uiCenter.y - 40; }
-                    else           { x = uiCenter.x;      y = uiCenter.y - 40; }
-                } else {
-                    if (nearRight) { x = uiCenter.x - 80; y = uiCenter.y + 20; }
-                    else           { x = uiCenter.x;      y = uiCenter.y + 20; }
-                }
-                x -= 5.5 * previewBuffer.length();
-
-                // Ensure labels are not clipped by the zoom circle
-                cairo_reset_clip(PCAIRO);
-
-                // Draw stacked labels first (duplicates), animating above/below
-                if (!m_previewStack.empty()) {
-                    cairo_select_font_face(PCAIRO, "monospace", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-                    cairo_set_font_size(PCAIRO, 18);
-                    const double baseYForText = (placeAbove ? uiCenter.y - 20 : uiCenter.y + 40);
-                    for (size_t i = 0; i < m_previewStack.size(); ++i) {
-                        const auto& item = m_previewStack[i];
-                        const double yOff = item.offsetCurrentUI;
-                        const double wI   = 8 + (11 * item.text.length());
-
-                        // Bubble
-                        cairo_set_source_rgba(PCAIRO, 0.0, 0.0, 0.0, 0.75);
-                        cairo_move_to(PCAIRO, x + radius, y + yOff);
-                        cairo_arc(PCAIRO, x + wI - radius, y + radius + yOff, radius, -M_PI_2, 0);
-                        cairo_arc(PCAIRO, x + wI - radius, y + height - radius + yOff, radius, 0, M_PI_2);
-                        cairo_arc(PCAIRO, x + radius, y + height - radius + yOff, radius, M_PI_2, M_PI);
-                        cairo_arc(PCAIRO, x + radius, y + radius + yOff, radius, M_PI, -M_PI_2);
-                        cairo_close_path(PCAIRO);
-                        cairo_fill(PCAIRO);
-
-                        // Text
-                        cairo_set_source_rgba(PCAIRO, 1.0, 1.0, 1.0, 1.0);
-                        const double textXI = x + 5.0;
-                        cairo_move_to(PCAIRO, textXI, baseYForText + yOff);
-                        cairo_show_text(PCAIRO, item.text.c_str());
-                    }
-                }
+    pSurface->dirty = false;
 
-                // Draw the current top label
-                // Ensure background fill is black (previous text set the source to white)
-                cairo_set_source_rgba(PCAIRO, 0.0, 0.0, 0.0, 0.75);
-                cairo_move_to(PCAIRO, x + radius, y);
-                cairo_arc(PCAIRO, x + width - radius, y + radius, radius, -M_PI_2, 0);
-                cairo_arc(PCAIRO, x + width - radius, y + height - radius, radius, 0, M_PI_2);
-                cairo_arc(PCAIRO, x + radius, y + height - radius, radius, M_PI_2, M_PI);
-                cairo_arc(PCAIRO, x + radius, y + radius, radius, M_PI, -M_PI_2);
+    {
+        Stats::CTimer background(Stats::STAGE_BACKGROUND, pSurface->m_pMonitor->name);
+        pSurface->setBackground(!m_bLive && (ACTIVE || (m_bRenderInactive && m_bCoordsInitialized)));
+    }
 
-                cairo_close_path(PCAIRO);
-                cairo_fill(PCAIRO);
+    if (!ACTIVE || m_bNoZoom) {
+        pSurface->hideLens();
+        pSurface->commitFrame();
+        pSurface->rendered = true;
+        return;
+    }
 
-                // Now draw the current label text in white
-                cairo_set_source_rgba(PCAIRO, 1.0, 1.0, 1.0, 1.0);
-                cairo_select_font_face(PCAIRO, "monospace", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-                cairo_set_font_size(PCAIRO, 18);
+    // draw at surface coordinates first, the extents decide where the lens surface goes and how big it is
+    const auto RECORDING = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
+    const auto RECCAIRO  = cairo_create(RECORDING);
+    CRegion    overlay;
+    renderOverlay(pSurface, RECCAIRO, pSurface->canvasSize, overlay);
+    cairo_destroy(RECCAIRO);
+
+    overlay.intersect(0, 0, pSurface->canvasSize.x, pSurface->canvasSize.y);
+    const auto EXTENTS = overlay.getExtents();
+
+    if (EXTENTS.w <= 0 || EXTENTS.h <= 0) {
+        cairo_surface_destroy(RECORDING);
+        pSurface->hideLens();
+        pSurface->commitFrame();
+        pSurface->rendered = true;
+        return;
+    }
 
-                double padding = 5.0;
-                double textX   = x + padding;
+    // buffer pixels per logical pixel, and the smallest logical step that lands on a whole buffer pixel (2 for 1.5, 4 for 1.25),
+    // so the lens maps 1:1 onto the pixels it covers
+    const double SCALE = pSurface->canvasSize.x / pSurface->m_pMonitor->size.x;
+    int          step  = 1;
+    while (step < 120 && std::abs(step * SCALE - std::round(step * SCALE)) > 0.001) {
+        step++;
+    }
 
-                if (placeAbove)
-                    cairo_move_to(PCAIRO, textX, uiCenter.y - 20);
-                else
-                    cairo_move_to(PCAIRO, textX, uiCenter.y + 40);
+    const auto   ALIGNDOWN = [step](double v) { return std::floor(v / step) * step; };
+    const auto   ALIGNUP   = [step](double v) { return std::ceil(v / step) * step; };
+    const auto   POS       = Vector2D{ALIGNDOWN(EXTENTS.x / SCALE), ALIGNDOWN(EXTENTS.y / SCALE)};
+    const auto   NEEDED    = Vector2D{ALIGNUP((EXTENTS.x + EXTENTS.w) / SCALE) - POS.x, ALIGNUP((EXTENTS.y + EXTENTS.h) / SCALE) - POS.y};
+
+    // grow in coarse steps and shrink only when far too big, so the chain isn't rebuilt on every frame
+    const double SLACK   = step * std::ceil(32.0 / step);
+    const auto   CURRENT = pSurface->lensSwapchain.size() / SCALE;
+    if (pSurface->lensSwapchain.empty() || NEEDED.x > CURRENT.x || NEEDED.y > CURRENT.y || NEEDED.x * NEEDED.y * 4 < CURRENT.x * CURRENT.y)
+        pSurface->lensSwapchain.resize((Vector2D{std::ceil(NEEDED.x / SLACK), std::ceil(NEEDED.y / SLACK)} * SLACK * SCALE).round());
+
+    const auto PBUFFER = pSurface->lensSwapchain.acquire();
+    if (!PBUFFER) {
+        cairo_surface_destroy(RECORDING);
+        pSurface->renderPending = true;
+        pSurface->dirty         = true;
+        return;
+    }
 
-                cairo_show_text(PCAIRO, previewBuffer.c_str());
+    pSurface->renderPending = false;
 
-                cairo_surface_flush(PBUFFER->surface);
-            }
-            cairo_restore(PCAIRO);
-            cairo_pattern_destroy(PATTERN);
+    const auto SURFACE =
+        cairo_image_surface_create_for_data((unsigned char*)PBUFFER->data, CAIRO_FORMAT_ARGB32, PBUFFER->pixelSize.x, PBUFFER->pixelSize.y, PBUFFER->pixelSize.x * 4);
+    const auto PCAIRO = cairo_create(SURFACE);
+
+    cairo_set_operator(PCAIRO, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_rgba(PCAIRO, 0, 0, 0, 0);
+    cairo_paint(PCAIRO);
+
+    cairo_set_operator(PCAIRO, CAIRO_OPERATOR_OVER);
+    cairo_set_source_surface(PCAIRO, RECORDING, -std::round(POS.x * SCALE), -std::round(POS.y * SCALE));
+    cairo_paint(PCAIRO);
 
-            // removed custom cursor overlay drawing
+    cairo_surface_flush(SURFACE);
+    cairo_destroy(PCAIRO);
+    cairo_surface_destroy(SURFACE);
+    cairo_surface_destroy(RECORDING);
+
+    pSurface->sendLens(PBUFFER, POS, (PBUFFER->pixelSize / SCALE).round());
+    pSurface->commitFrame();
+
+    pSurface->rendered = true;
+}
+
+// Draws the lens, ring and preview labels around the pointer into cr, whose target covers the whole surface at canvasSize buffer pixels.
+// Adds what it covers to overlay.
+void CHyprpicker::renderOverlay(CLayerSurface* pSurface, cairo_t* cr, const Vector2D& canvasSize, CRegion& overlay) {
+    const auto SCALEBUFS      = pSurface->screenBuffer->pixelSize / canvasSize;
+    const auto MOUSECOORDSABS = m_vLastCoords.floor() / pSurface->m_pMonitor->size;
+    const auto CLICKPOS       = MOUSECOORDSABS * canvasSize;
+
+    // Compute center position with keyboard nudge applied (in buffer pixels)
+    const auto BASEPOSBUF = CLICKPOS / canvasSize * pSurface->screenBuffer->pixelSize;
+    Vector2D    centerBuf = BASEPOSBUF + m_vNudgeBufPx;
+    // Clamp to valid pixel range
+    centerBuf.x           = std::clamp(centerBuf.x, 0.0, pSurface->screenBuffer->pixelSize.x - 1.0);
+    centerBuf.y           = std::clamp(centerBuf.y, 0.0, pSurface->screenBuffer->pixelSize.y - 1.0);
+
+    // UI center should move with the nudge as well. Convert the nudge (screenBuffer pixels)
+    // into this surface's buffer coordinates and offset the on-screen UI accordingly.
+    const auto SCALEBUFS_INV = Vector2D{1.0 / SCALEBUFS.x, 1.0 / SCALEBUFS.y};
+    Vector2D    uiCenter     = CLICKPOS + (m_vNudgeBufPx * SCALEBUFS_INV);
+    uiCenter.x               = std::clamp(uiCenter.x, 0.0, canvasSize.x - 1.0);
+    uiCenter.y               = std::clamp(uiCenter.y, 0.0, canvasSize.y - 1.0);
+
+    // Springs start at rest on their targets, after that only stepAnimations moves them
+    if (!m_zoomAnimInitialized) {
+        m_zoomAnimInitialized    = true;
+        m_zoomRadiusCurrentSrcPx = m_zoomRadiusTargetSrcPx;
+        m_zoomRadiusVel          = 0.0;
+        m_zoomMagCurrent         = m_zoomMagTarget;
+        m_zoomMagVel             = 0.0;
+        if (!m_zoomMagBaseSet) {
+            m_zoomMagBase    = m_zoomMagTarget;
+            m_zoomMagBaseSet = true;
         }
-    } else if (!m_bRenderInactive && m_bCoordsInitialized) {
-        cairo_set_operator(PCAIRO, CAIRO_OPERATOR_SOURCE);
-        cairo_set_source_rgba(PCAIRO, 0, 0, 0, 0);
-        cairo_rectangle(PCAIRO, 0, 0, PBUFFER->pixelSize.x, PBUFFER->pixelSize.y);
-        cairo_fill(PCAIRO);
-    } else if (m_bCoordsInitialized) {
-        const auto SCALEBUFS  = pSurface->screenBuffer->pixelSize / PBUFFER->pixelSize;
-        const auto PATTERNPRE = cairo_pattern_create_for_surface(pSurface->screenBuffer->surface);
-        cairo_pattern_set_filter(PATTERNPRE, CAIRO_FILTER_BILINEAR);
-        cairo_matrix_t matrixPre;
-        cairo_matrix_init_identity(&matrixPre);
-        cairo_matrix_scale(&matrixPre, SCALEBUFS.x, SCALEBUFS.y);
-        cairo_pattern_set_matrix(PATTERNPRE, &matrixPre);
-        cairo_set_source(PCAIRO, PATTERNPRE);
-        cairo_paint(PCAIRO);
+        // Aperture will be preserved on ALT zoom using current values at the event
+    }
 
-        cairo_surface_flush(PBUFFER->surface);
-        cairo_pattern_destroy(PATTERNPRE);
+    // Keep the zoom circle centered at the (possibly nudged) UI center
+    const double cellWForRadius = m_zoomMagCurrent / SCALEBUFS.x;
+    const double zoomRadiusUI   = m_zoomRadiusCurrentSrcPx * cellWForRadius;
+    const double onePxUI        = 1.0 / std::min(SCALEBUFS.x, SCALEBUFS.y);
+    const double lensExtentUI   = NOverlay::lensExtent(zoomRadiusUI, onePxUI);
+
+    // --live: a lens on top of the pixels it shows would capture itself, so it moves diagonally off the pointer, far enough to clear
+    // lensSourceBox, and flips to the other side near the edges
+    Vector2D     lensOffset;
+    if (m_bLive) {
+        const double SOURCEHALF = (std::ceil(std::max(m_zoomRadiusCurrentSrcPx, m_zoomRadiusTargetSrcPx)) + 3) / std::min(SCALEBUFS.x, SCALEBUFS.y);
+        const double DISTANCE   = (lensExtentUI + 8 * onePxUI) / M_SQRT2 + SOURCEHALF;
+
+        lensOffset = {uiCenter.x + DISTANCE + lensExtentUI > canvasSize.x ? -DISTANCE : DISTANCE, uiCenter.y + DISTANCE + lensExtentUI > canvasSize.y ? -DISTANCE : DISTANCE};
+        uiCenter   = uiCenter + lensOffset;
+    }
 
-        // removed custom cursor overlay drawing
+    // make sure the source pixels the lens samples are converted
+    if (!pSurface->screenBuffer->fullyConverted()) {
+        Stats::CTimer  convert(Stats::STAGE_CONVERT, pSurface->m_pMonitor->name);
+
+        const double   INVMAG = 1.0 / std::max(0.01, m_zoomMagCurrent);
+        const Vector2D DSTAT  = centerBuf / SCALEBUFS + lensOffset;
+        const Vector2D SRCMIN = centerBuf + Vector2D{0.5, 0.5} + (uiCenter - Vector2D{zoomRadiusUI, zoomRadiusUI} - DSTAT - Vector2D{0.5, 0.5}) * INVMAG;
+        const Vector2D SRCMAX = centerBuf + Vector2D{0.5, 0.5} + (uiCenter + Vector2D{zoomRadiusUI, zoomRadiusUI} - DSTAT - Vector2D{0.5, 0.5}) * INVMAG;
+        pSurface->screenBuffer->ensureRect(std::floor(SRCMIN.x) - 1, std::floor(SRCMIN.y) - 1, std::ceil(SRCMAX.x - SRCMIN.x) + 3, std::ceil(SRCMAX.y - SRCMIN.y) + 3);
     }
 
-    pSurface->sendFrame();
-    cairo_destroy(PCAIRO);
-    cairo_surface_destroy(PBUFFER->surface);
+    const auto       PIXCOLOR = getColorFromPixel(pSurface, centerBuf);
+
+    NOverlay::SState state = {
+        .srcPixel      = centerBuf,
+        .srcPerCanvas  = SCALEBUFS,
+        .center        = uiCenter,
+        .offset        = lensOffset,
+        .radius        = zoomRadiusUI,
+        .magnification = m_zoomMagCurrent,
+        .onePx         = onePxUI,
+        .color         = PIXCOLOR,
+        .stack         = &m_previewStack,
+        .monitor       = pSurface->m_pMonitor->name,
+    };
 
-    PBUFFER->busy    = true;
-    PBUFFER->cairo   = nullptr;
-    PBUFFER->surface = nullptr;
+    if (!m_bDisablePreview) {
+        // Decide label stack direction: keep below the circle UI (positive Y), unless too close to bottom
+        const bool   placeAboveDir = uiCenter.y > (canvasSize.y - 80); // only go above when near bottom edge
+        const double dirSign       = placeAboveDir ? -1.0 : 1.0;       // negative Y is up
+        // Update target offsets every frame so stack follows circle (newest closest to active)
+        const size_t nStack    = m_previewStack.size();
+        const double stackStep = LABEL_HEIGHT_UI_PX + LABEL_STACK_MARGIN_UI_PX;
+        for (size_t i = 0; i < nStack; ++i)
+            m_previewStack[i].offsetTargetUI = dirSign * static_cast<double>(nStack - i) * stackStep;
+
+        state.label = Hyprpicker::format({.r = PIXCOLOR.r, .g = PIXCOLOR.g, .b = PIXCOLOR.b, .a = PIXCOLOR.a}, libFormat(m_bSelectedOutputMode), m_bUseLowerCase);
+        if (const auto AREA = NSample::describe(m_eSampleMode, m_iSampleRadius); !AREA.empty())
+            state.label += "  " + AREA;
+
+        if (!m_pLabelText)
+            m_pLabelText = std::make_unique<CTextAtlas>("monospace", 18);
+        state.text = m_pLabelText.get();
+    }
 
-    pSurface->rendered = true;
+    const auto              SCREEN = pSurface->screenBuffer;
+    const NResample::SImage SRC    = {.data = (uint8_t*)SCREEN->data, .width = (uint32_t)SCREEN->pixelSize.x, .height = (uint32_t)SCREEN->pixelSize.y, .stride = SCREEN->stride};
+
+    NOverlay::draw(cr, canvasSize, SRC, state, overlay);
+
+    // keep rendering on frame callbacks until everything settled
+    if (animating())
+        pSurface->dirty = true;
+}
+
+void CHyprpicker::tickAnimations(CLayerSurface* pSurface, uint32_t frameTimeMs) {
+    if (pSurface != m_pLastSurface)
+        return;
+
+    if (!animating()) {
+        // the next animation starts its clock on its own first frame, however long we were idle
+        m_bAnimClockValid = false;
+        return;
+    }
+
+    const double dt   = m_bAnimClockValid ? (frameTimeMs - m_animLastFrameMs) / 1000.0 : 0.0;
+    m_animLastFrameMs = frameTimeMs;
+    m_bAnimClockValid = true;
+
+    stepAnimations(std::min(dt, SPRING_MAX_DT));
+
+    pSurface->dirty = true;
+}
+
+void CHyprpicker::stepAnimations(double dt) {
+    if (dt <= 0.0)
+        return;
+
+    // Snappier critically-damped spring
+    const double k    = SPRING_K;
+    const double zeta = SPRING_ZETA;
+    const double c    = 2.0 * std::sqrt(k) * zeta;
+    // Radius
+    {
+        const double x = m_zoomRadiusCurrentSrcPx - m_zoomRadiusTargetSrcPx;
+        const double a = (-k * x) - (c * m_zoomRadiusVel);
+        m_zoomRadiusVel += a * dt;
+        m_zoomRadiusCurrentSrcPx += m_zoomRadiusVel * dt;
+        // Snap when very close to avoid jitter
+        if (std::abs(m_zoomRadiusCurrentSrcPx - m_zoomRadiusTargetSrcPx) < 0.01 && std::abs(m_zoomRadiusVel) < 0.01) {
+            m_zoomRadiusCurrentSrcPx = m_zoomRadiusTargetSrcPx;
+            m_zoomRadiusVel          = 0.0;
+        }
+    }
+    // Magnification
+    {
+        const double xM = m_zoomMagCurrent - m_zoomMagTarget;
+        const double aM = (-k * xM) - (c * m_zoomMagVel);
+        m_zoomMagVel += aM * dt;
+        m_zoomMagCurrent += m_zoomMagVel * dt;
+        if (std::abs(m_zoomMagCurrent - m_zoomMagTarget) < 0.01 && std::abs(m_zoomMagVel) < 0.01) {
+            m_zoomMagCurrent = m_zoomMagTarget;
+            m_zoomMagVel     = 0.0;
+        }
+    }
+    // If locking aperture (ALT zoom transition), force radius to keep UI circle constant
+    if (m_lockAperture) {
+        const double targetR = (m_zoomMagCurrent > 0.01) ? (m_lockedAperture / m_zoomMagCurrent) : m_zoomRadiusCurrentSrcPx;
+        m_zoomRadiusCurrentSrcPx = targetR;
+        m_zoomRadiusTargetSrcPx  = targetR;
+        m_zoomRadiusVel          = 0.0;
+        // Release the lock once magnification settles at target
+        if (std::abs(m_zoomMagCurrent - m_zoomMagTarget) < 0.01 && std::abs(m_zoomMagVel) < 0.01)
+            m_lockAperture = false;
+    }
+
+    // Ease stacked label offsets towards their targets, snapping the last bit so they settle
+    const double alpha = std::clamp(dt * LABEL_ANIM_SPEED, 0.0, 1.0);
+    for (auto& item : m_previewStack) {
+        item.offsetCurrentUI += (item.offsetTargetUI - item.offsetCurrentUI) * alpha;
+        if (std::abs(item.offsetTargetUI - item.offsetCurrentUI) < 0.1)
+            item.offsetCurrentUI = item.offsetTargetUI;
+    }
+}
+
+bool CHyprpicker::animating() const {
+    if (m_zoomRadiusVel != 0.0 || m_zoomMagVel != 0.0 || m_lockAperture)
+        return true;
+
+    if (m_zoomRadiusCurrentSrcPx != m_zoomRadiusTargetSrcPx || m_zoomMagCurrent != m_zoomMagTarget)
+        return true;
+
+    if (m_bDisablePreview)
+        return false;
+
+    return std::ranges::any_of(m_previewStack, [](const auto& item) { return item.offsetCurrentUI != item.offsetTargetUI; });
 }
 
 // Consolidated scroll helpers
@@ -795,6 +1206,37 @@ void CHyprpicker::handleAltToggle(bool toTriple) {
         m_zoomRadiusTargetSrcPx = std::clamp(m_lockedAperture / m_zoomMagTarget, ZOOM_RADIUS_MIN, ZOOM_RADIUS_MAX);
 }
 
+bool CHyprpicker::handleSampleScroll(double steps, bool discrete) {
+    if (!m_pXKBState || !xkb_state_mod_name_is_active(m_pXKBState, XKB_MOD_NAME_CTRL, XKB_STATE_MODS_EFFECTIVE))
+        return false;
+
+    // wheels send discrete steps first and the same scroll as an axis event after them, which must not count twice
+    if (discrete) {
+        m_bSampleScrollDiscrete = true;
+        m_fSampleScroll += steps;
+    } else if (m_bSampleScrollDiscrete) {
+        m_bSampleScrollDiscrete = false;
+        return true;
+    } else
+        m_fSampleScroll += steps / SAMPLE_SCROLL_STEP;
+
+    // high resolution wheels and touchpads move in fractions of a step
+    const double WHOLE = std::trunc(m_fSampleScroll);
+    m_fSampleScroll -= WHOLE;
+
+    if (WHOLE == 0)
+        return true;
+
+    // up grows the area
+    const int RADIUS = std::clamp(m_iSampleRadius - (int)WHOLE, 0, SAMPLE_RADIUS_MAX);
+    if (RADIUS != m_iSampleRadius) {
+        m_iSampleRadius = RADIUS;
+        markDirty(m_pLastSurface);
+    }
+
+    return true;
+}
+
 void CHyprpicker::handleRadiusToggle(bool toDouble) {
     // Seed base UI aperture from the current circle size
     if (!m_apertureBaseSet) {
@@ -816,14 +1258,25 @@ CColor CHyprpicker::getColorFromPixel(CLayerSurface* pLS, Vector2D pix) {
     if (pix.x >= pLS->screenBuffer->pixelSize.x || pix.y >= pLS->screenBuffer->pixelSize.y || pix.x < 0 || pix.y < 0)
         return CColor{.r = 0, .g = 0, .b = 0, .a = 0};
 
-    void* dataSrc = pLS->screenBuffer->paddedData ? pLS->screenBuffer->paddedData : pLS->screenBuffer->data;
+    if (m_iSampleRadius > 0) {
+        // the table makes any radius O(1) on a frozen screen. With --live the pixels change every frame, there the few around
+        // the pointer are summed directly instead of rebuilding it.
+        if (!pLS->sampleTable && !m_bLive && m_eSampleMode != SAMPLE_MEDIAN) {
+            Stats::CTimer timer(Stats::STAGE_CONVERT, pLS->m_pMonitor->name);
+            pLS->sampleTable = std::make_unique<CSummedAreaTable>(*pLS->screenBuffer, m_pWorkerPool.get());
+        }
+
+        return NSample::sample(*pLS->screenBuffer, pLS->sampleTable.get(), m_eSampleMode, pix.x, pix.y, m_iSampleRadius);
+    }
+
+    pLS->screenBuffer->ensureRect(pix.x, pix.y, 1, 1);
 
     struct SPixel {
         unsigned char blue;
         unsigned char green;
         unsigned char red;
         unsigned char alpha;
-    }* px = (struct SPixel*)((char*)dataSrc + ((ptrdiff_t)pix.y * (int)pLS->screenBuffer->pixelSize.x * 4) + ((ptrdiff_t)pix.x * 4));
+    }* px = (struct SPixel*)((char*)pLS->screenBuffer->data + ((ptrdiff_t)pix.y * pLS->screenBuffer->stride) + ((ptrdiff_t)pix.x * 4));
 
     return CColor{.r = px->red, .g = px->green, .b = px->blue, .a = px->alpha};
 }
@@ -831,9 +1284,6 @@ CColor CHyprpicker::getColorFromPixel(CLayerSurface* pLS, Vector2D pix) {
 void CHyprpicker::finalizePickAtCurrent(bool forceFinalize) {
     if (!m_pLastSurface)
         return;
-    // relative brightness of a color
-    const auto FLUMI = [](const float& c) -> float { return c <= 0.03928 ? c / 12.92 : powf((c + 0.055) / 1.055, 2.4); };
-
     // get the px and print it (apply keyboard nudge in screen buffer pixels)
     const auto MOUSECOORDSABS = m_vLastCoords.floor() / m_pLastSurface->m_pMonitor->size;
     Vector2D   CLICKPOS       = MOUSECOORDSABS * m_pLastSurface->screenBuffer->pixelSize;
@@ -843,51 +1293,7 @@ void CHyprpicker::finalizePickAtCurrent(bool forceFinalize) {
 
     const auto COL = getColorFromPixel(m_pLastSurface, CLICKPOS);
 
-    const uint8_t FG = 0.2126 * FLUMI(COL.r / 255.0f) + 0.7152 * FLUMI(COL.g / 255.0f) + 0.0722 * FLUMI(COL.b / 255.0f) > 0.17913 ? 0 : 255;
-
-    auto          toHex = [this](int i) -> std::string {
-        const char* DS = m_bUseLowerCase ? "0123456789abcdef" : "0123456789ABCDEF";
-
-        std::string result = "";
-
-        result += DS[i / 16];
-        result += DS[i % 16];
-
-        return result;
-    };
-
-    std::string hexColor = std::format("#{0:02x}{1:02x}{2:02x}", COL.r, COL.g, COL.b);
-
-    // Prepare outputs
-    std::string formattedColor;
-    switch (m_bSelectedOutputMode) {
-        case OUTPUT_CMYK: {
-            float c, m, y, k;
-            COL.getCMYK(c, m, y, k);
-
-            formattedColor = std::format("{}% {}% {}% {}%", c, m, y, k);
-            break; 
-        }
-        case OUTPUT_HEX: {
-            formattedColor = hexColor;
-            break;
-        }
-        case OUTPUT_RGB: {
-            formattedColor = std::format("{} {} {}", COL.r, COL.g, COL.b);
-            break;
-        }
-        case OUTPUT_HSL:
-        case OUTPUT_HSV: {
-            float h, s, l_or_v;
-            if (m_bSelectedOutputMode == OUTPUT_HSV)
-                COL.getHSV(h, s, l_or_v);
-            else
-                COL.getHSL(h, s, l_or_v);
-
-            formattedColor = std::format("{} {}% {}%", h, s, l_or_v);
-            break;
-        }
-    }
+    const std::string formattedColor = formatColor(COL);
 
     // Decide multi-pick vs single pick
     const bool withShift = (m_pXKBState && xkb_state_mod_name_is_active(m_pXKBState, XKB_MOD_NAME_SHIFT, XKB_STATE_MODS_EFFECTIVE));
@@ -897,16 +1303,17 @@ void CHyprpicker::finalizePickAtCurrent(bool forceFinalize) {
             m_multiMode = true;
             m_multiBuffer.push_back(formattedColor);
             // Push a stacked preview label and set its target offset (most recent nearest to active)
-            m_previewStack.push_back(SLabelStackItem{.text = formattedColor});
+            m_previewStack.push_back(NOverlay::SStackedLabel{.text = formattedColor});
             const size_t n = m_previewStack.size();
             for (size_t i = 0; i < n; ++i)
                 m_previewStack[i].offsetTargetUI = (n - i) * LABEL_STACK_SPACING_UI_PX;
+            markDirty(m_pLastSurface);
             return;
         } else if (m_multiMode) {
             // Non-shift click after accumulating: add and finalize
             m_multiBuffer.push_back(formattedColor);
             // Also add to stack for a final frame (if any)
-            m_previewStack.push_back(SLabelStackItem{.text = formattedColor});
+            m_previewStack.push_back(NOverlay::SStackedLabel{.text = formattedColor});
             const size_t n2 = m_previewStack.size();
             for (size_t i = 0; i < n2; ++i)
                 m_previewStack[i].offsetTargetUI = (n2 - i) * LABEL_STACK_SPACING_UI_PX;
@@ -919,14 +1326,14 @@ void CHyprpicker::finalizePickAtCurrent(bool forceFinalize) {
             if (m_bAutoCopy)
                 NClipboard::copy(joined);
             else
-                Debug::log(NONE, "%s", joined.c_str());
-            finish();
+                printOutput(joined);
+            endSession();
             return;
         }
     } else if (m_multiMode) {
         // Forced finalize (Enter) while batching: include current and finish
         m_multiBuffer.push_back(formattedColor);
-        m_previewStack.push_back(SLabelStackItem{.text = formattedColor});
+        m_previewStack.push_back(NOverlay::SStackedLabel{.text = formattedColor});
         const size_t n3 = m_previewStack.size();
         for (size_t i = 0; i < n3; ++i)
             m_previewStack[i].offsetTargetUI = (n3 - i) * LABEL_STACK_SPACING_UI_PX;
@@ -939,51 +1346,56 @@ void CHyprpicker::finalizePickAtCurrent(bool forceFinalize) {
         if (m_bAutoCopy)
             NClipboard::copy(joined);
         else
-            Debug::log(NONE, "%s", joined.c_str());
-        finish();
+            printOutput(joined);
+        endSession();
         return;
     }
 
     // Single pick legacy behavior
+    outputColor(COL);
+    endSession();
+}
+
+CBox CHyprpicker::lensSourceBox(CLayerSurface* pSurface) {
+    const auto   CENTER = (m_vLastCoords.floor() / pSurface->m_pMonitor->size * pSurface->screenBuffer->pixelSize + m_vNudgeBufPx).floor();
+    const double RADIUS = m_bNoZoom ? 1 : std::ceil(std::max(m_zoomRadiusCurrentSrcPx, m_zoomRadiusTargetSrcPx)) + 2;
+
+    return {CENTER.x - RADIUS, CENTER.y - RADIUS, 2 * RADIUS + 1, 2 * RADIUS + 1};
+}
+
+std::string CHyprpicker::formatColor(const CColor& COL) {
+    // what gets copied and sent has always been lowercase hex, whatever is printed
+    return Hyprpicker::format({.r = COL.r, .g = COL.g, .b = COL.b, .a = COL.a}, libFormat(m_bSelectedOutputMode), true);
+}
+
+std::string CHyprpicker::colorText(const CColor& COL) {
+    // relative brightness of a color
+    const auto FLUMI = [](const float& c) -> float { return c <= 0.03928 ? c / 12.92 : powf((c + 0.055) / 1.055, 2.4); };
+
+    const uint8_t FG = 0.2126 * FLUMI(COL.r / 255.0f) + 0.7152 * FLUMI(COL.g / 255.0f) + 0.0722 * FLUMI(COL.b / 255.0f) > 0.17913 ? 0 : 255;
+
+    auto          toHex = [this](int i) -> std::string {
+        const char* DS = m_bUseLowerCase ? "0123456789abcdef" : "0123456789ABCDEF";
+
+        std::string result = "";
+
+        result += DS[i / 16];
+        result += DS[i % 16];
+
+        return result;
+    };
+
+    // unlike formatColor, follows --lowercase-hex
+    std::string text;
     switch (m_bSelectedOutputMode) {
         case OUTPUT_CMYK: {
             float c, m, y, k;
             COL.getCMYK(c, m, y, k);
-            if (m_bFancyOutput)
-                Debug::log(NONE, "\033[38;2;%i;%i;%i;48;2;%i;%i;%im%g%% %g%% %g%% %g%%\033[0m", FG, FG, FG, COL.r, COL.g, COL.b, c, m, y, k);
-            else
-                Debug::log(NONE, "%g%% %g%% %g%% %g%%", c, m, y, k);
-            if (m_bAutoCopy)
-                NClipboard::copy(formattedColor);
-            if (m_bNotify)
-                NNotify::send(hexColor, formattedColor);
-            finish();
-            break;
-        }
-        case OUTPUT_HEX: {
-            if (m_bFancyOutput)
-                Debug::log(NONE, "\033[38;2;%i;%i;%i;48;2;%i;%i;%im#%s%s%s\033[0m", FG, FG, FG, COL.r, COL.g, COL.b, toHex(COL.r).c_str(), toHex(COL.g).c_str(), toHex(COL.b).c_str());
-            else
-                Debug::log(NONE, "#%s%s%s", toHex(COL.r).c_str(), toHex(COL.g).c_str(), toHex(COL.b).c_str());
-            if (m_bAutoCopy)
-                NClipboard::copy(formattedColor);
-            if (m_bNotify)
-                NNotify::send(hexColor, hexColor);
-            finish();
-            break;
-        }
-        case OUTPUT_RGB: {
-            if (m_bFancyOutput)
-                Debug::log(NONE, "\033[38;2;%i;%i;%i;48;2;%i;%i;%im%i %i %i\033[0m", FG, FG, FG, COL.r, COL.g, COL.b, COL.r, COL.g, COL.b);
-            else
-                Debug::log(NONE, "%i %i %i", COL.r, COL.g, COL.b);
-            if (m_bAutoCopy)
-                NClipboard::copy(formattedColor);
-            if (m_bNotify)
-                NNotify::send(hexColor, formattedColor);
-            finish();
+            text = std::format("{:g}% {:g}% {:g}% {:g}%", c, m, y, k);
             break;
         }
+        case OUTPUT_HEX: text = "#" + toHex(COL.r) + toHex(COL.g) + toHex(COL.b); break;
+        case OUTPUT_RGB: text = std::format("{} {} {}", COL.r, COL.g, COL.b); break;
         case OUTPUT_HSL:
         case OUTPUT_HSV: {
             float h, s, l_or_v;
@@ -991,107 +1403,104 @@ void CHyprpicker::finalizePickAtCurrent(bool forceFinalize) {
                 COL.getHSV(h, s, l_or_v);
             else
                 COL.getHSL(h, s, l_or_v);
-            if (m_bFancyOutput)
-                Debug::log(NONE, "\033[38;2;%i;%i;%i;48;2;%i;%i;%im%g %g%% %g%%\033[0m", FG, FG, FG, COL.r, COL.g, COL.b, h, s, l_or_v);
-            else
-                Debug::log(NONE, "%g %g%% %g%%", h, s, l_or_v);
-            if (m_bAutoCopy)
-                NClipboard::copy(formattedColor);
-            if (m_bNotify)
-                NNotify::send(hexColor, formattedColor);
-            finish();
+            text = std::format("{:g} {:g}% {:g}%", h, s, l_or_v);
             break;
         }
     }
+
+    if (m_bFancyOutput)
+        return std::format("\033[38;2;{0};{0};{0};48;2;{1};{2};{3}m{4}\033[0m", FG, COL.r, COL.g, COL.b, text);
+
+    return text;
 }
 
-void CHyprpicker::startRepeatThread() {
-    if (m_repeatThreadRunning.exchange(true))
-        return;
+void CHyprpicker::outputColor(const CColor& COL) {
+    const std::string hexColor       = std::format("#{0:02x}{1:02x}{2:02x}", COL.r, COL.g, COL.b);
+    const std::string formattedColor = formatColor(COL);
 
-    m_repeatThread = std::thread([this]() {
-        using namespace std::chrono;
-        bool                         anyPrev = false;
-        steady_clock::time_point     pressStart{};
-        steady_clock::time_point     nextRepeat{};
-
-        while (true) {
-            const bool any = m_keyLeft || m_keyRight || m_keyUp || m_keyDown;
-
-            if (any) {
-                const auto now = steady_clock::now();
-                if (!anyPrev) {
-                    anyPrev    = true;
-                    pressStart = now;
-                    nextRepeat = pressStart + milliseconds(std::max(0, m_repeatDelay.load()));
-                } else {
-                    const int rate = m_repeatRate.load();
-                    if (rate > 0) {
-                        if (now >= nextRepeat) {
-                            const double step = (m_pXKBState && xkb_state_mod_name_is_active(m_pXKBState, XKB_MOD_NAME_SHIFT, XKB_STATE_MODS_EFFECTIVE)) ? 8.0 : 1.0;
-                            if (!m_bNoZoom && m_bCoordsInitialized && m_pLastSurface) {
-                                if (m_keyLeft)
-                                    m_vNudgeBufPx.x -= step;
-                                if (m_keyRight)
-                                    m_vNudgeBufPx.x += step;
-                                if (m_keyUp)
-                                    m_vNudgeBufPx.y -= step;
-                                if (m_keyDown)
-                                    m_vNudgeBufPx.y += step;
-                                markDirty();
-                            }
-                            // schedule next
-                            nextRepeat = now + duration_cast<milliseconds>(duration<double>(1.0 / static_cast<double>(rate)));
-                        }
-                    }
-                }
-            } else {
-                anyPrev = false;
-            }
+    printOutput(colorText(COL));
 
-            std::this_thread::sleep_for(milliseconds(5));
-        }
-    });
-    m_repeatThread.detach();
+    if (m_bAutoCopy)
+        NClipboard::copy(formattedColor);
+    if (m_bNotify)
+        NNotify::send(hexColor, m_bSelectedOutputMode == OUTPUT_HEX ? hexColor : formattedColor);
 }
 
-void CHyprpicker::initKeyboard() {
-    m_pKeyboard->setKeymap([this](CCWlKeyboard* r, wl_keyboard_keymap_format format, int32_t fd, uint32_t size) {
-        if (!m_pXKBContext)
-            return;
+void CHyprpicker::printOutput(const std::string& text) {
+    if (m_bDaemon)
+        m_szSessionOutput += text + "\n";
+    else
+        Debug::log(NONE, "%s", text.c_str());
+}
 
-        if (format != WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1) {
-            Debug::log(ERR, "Could not recognise keymap format");
-            return;
-        }
+void CHyprpicker::updateRepeat() {
+    const bool HELD = m_keyLeft || m_keyRight || m_keyUp || m_keyDown;
 
-        const char* buf = (const char*)mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
-        if (buf == MAP_FAILED) {
-            Debug::log(ERR, "Failed to mmap xkb keymap: %d", errno);
-            return;
-        }
+    // 0 disables repeat
+    if (HELD == m_bRepeatArmed || (HELD && m_repeatRate <= 0))
+        return;
 
-        m_pXKBKeymap = xkb_keymap_new_from_buffer(m_pXKBContext, buf, size - 1, XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+    itimerspec spec = {};
+    if (HELD) {
+        const long DELAYMS    = std::max(0, m_repeatDelay);
+        const long INTERVALNS = 1000000000L / m_repeatRate;
+        spec.it_value         = {.tv_sec = DELAYMS / 1000, .tv_nsec = (DELAYMS % 1000) * 1000000L};
+        spec.it_interval      = {.tv_sec = INTERVALNS / 1000000000L, .tv_nsec = INTERVALNS % 1000000000L};
+        // an all-zero it_value would disarm the timer
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+            spec.it_value.tv_nsec = 1;
+    }
 
-        munmap((void*)buf, size);
-        close(fd);
+    if (timerfd_settime(m_iRepeatFD, 0, &spec, nullptr) < 0) {
+        Debug::log(ERR, "Couldn't set the key repeat timer: %s", strerror(errno));
+        return;
+    }
 
-        if (!m_pXKBKeymap) {
-            Debug::log(ERR, "Failed to compile xkb keymap");
-            return;
-        }
+    m_bRepeatArmed = HELD;
+}
+
+void CHyprpicker::onRepeat() {
+    uint64_t repeats = 0;
+    if (read(m_iRepeatFD, &repeats, sizeof(repeats)) != sizeof(repeats) || repeats == 0)
+        return;
+
+    if (m_bNoZoom || !m_bCoordsInitialized || !m_pLastSurface)
+        return;
+
+    // repeats that piled up since the last wakeup all go into one nudge and one render
+    const double STEP = (m_pXKBState && xkb_state_mod_name_is_active(m_pXKBState, XKB_MOD_NAME_SHIFT, XKB_STATE_MODS_EFFECTIVE)) ? 8.0 : 1.0;
+    m_vNudgeBufPx.x += ((m_keyRight ? 1 : 0) - (m_keyLeft ? 1 : 0)) * STEP * repeats;
+    m_vNudgeBufPx.y += ((m_keyDown ? 1 : 0) - (m_keyUp ? 1 : 0)) * STEP * repeats;
 
-        m_pXKBState = xkb_state_new(m_pXKBKeymap);
-        if (!m_pXKBState) {
-            Debug::log(ERR, "Failed to create xkb state");
+    markDirty(m_pLastSurface);
+}
+
+void CHyprpicker::initKeyboard() {
+    m_pKeyboard->setKeymap([this](CCWlKeyboard* r, wl_keyboard_keymap_format format, int32_t fd, uint32_t size) {
+        if (!m_pXKBContext || format != WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1) {
+            if (m_pXKBContext)
+                Debug::log(ERR, "Could not recognise keymap format");
+            close(fd);
             return;
         }
-        // Start repeat thread now that keyboard is ready
-        startRepeatThread();
+
+        // compiling takes a while, so at startup it waits for the first frames (or the first key)
+        if (m_iKeymapFD >= 0)
+            close(m_iKeymapFD);
+        m_iKeymapFD   = fd;
+        m_iKeymapSize = size;
+
+        if (m_bStartupDone)
+            compileKeymap();
     });
 
     // Update xkb modifier state so Shift detection works
     m_pKeyboard->setModifiers([this](CCWlKeyboard* r, uint32_t serial, uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked, uint32_t group) {
+        m_iModsDepressed = mods_depressed;
+        m_iModsLatched   = mods_latched;
+        m_iModsLocked    = mods_locked;
+        m_iModsGroup     = group;
+
         if (m_pXKBState)
             xkb_state_update_mask(m_pXKBState, mods_depressed, mods_latched, mods_locked, 0, 0, group);
     });
@@ -1103,11 +1512,13 @@ void CHyprpicker::initKeyboard() {
     });
 
     m_pKeyboard->setKey([this](CCWlKeyboard* r, uint32_t serial, uint32_t time, uint32_t key, uint32_t state) {
+        compileKeymap();
+
         if (m_pXKBState) {
             const xkb_keysym_t sym = xkb_state_key_get_one_sym(m_pXKBState, key + 8);
             if (state == WL_KEYBOARD_KEY_STATE_PRESSED) {
                 if (sym == XKB_KEY_Escape) {
-                    finish(2);
+                    endSession(2);
                     return;
                 }
                 if (sym == XKB_KEY_Return || sym == XKB_KEY_KP_Enter) {
@@ -1124,8 +1535,10 @@ void CHyprpicker::initKeyboard() {
                         case XKB_KEY_Up: m_vNudgeBufPx.y -= step; m_keyUp = true; nudged = true; break;
                         case XKB_KEY_Down: m_vNudgeBufPx.y += step; m_keyDown = true; nudged = true; break;
                     }
-                    if (nudged)
-                        markDirty();
+                    if (nudged) {
+                        markDirty(m_pLastSurface);
+                        updateRepeat();
+                    }
                 }
             } else if (state == WL_KEYBOARD_KEY_STATE_RELEASED) {
                 switch (sym) {
@@ -1134,9 +1547,10 @@ void CHyprpicker::initKeyboard() {
                     case XKB_KEY_Up: m_keyUp = false; break;
                     case XKB_KEY_Down: m_keyDown = false; break;
                 }
+                updateRepeat();
             }
         } else if (key == 1 && state == WL_KEYBOARD_KEY_STATE_PRESSED) // Assume keycode 1 is escape
-            finish(2);
+            endSession(2);
     });
 }
 
@@ -1145,6 +1559,10 @@ void CHyprpicker::initMouse() {
         auto x = wl_fixed_to_double(surface_x);
         auto y = wl_fixed_to_double(surface_y);
 
+        // until the first enter every surface shows the plain screen, after it they all switch to the inactive look
+        const bool FIRSTENTER = !m_bCoordsInitialized;
+        const auto PREVIOUS   = m_pLastSurface;
+
         m_vLastCoords        = {x, y};
         m_bCoordsInitialized = true;
         m_vNudgeBufPx        = {0, 0};
@@ -1158,12 +1576,27 @@ void CHyprpicker::initMouse() {
 
         // Hide the system cursor when hyprpicker is active
         // Wayland: set a null cursor surface to hide pointer
-        m_pPointer->sendSetCursor(serial, nullptr, 0, 0);
+        // --live moves the lens off the pointer, so a crosshair shows what is picked. Captures never include the cursor.
+        if (m_bLive && m_pCursorShapeMgr && !m_pCursorShapeDevice)
+            m_pCursorShapeDevice = makeShared<CCWpCursorShapeDeviceV1>(m_pCursorShapeMgr->sendGetPointer(m_pPointer->resource()));
 
-        markDirty();
+        if (m_bLive && m_pCursorShapeDevice)
+            m_pCursorShapeDevice->sendSetShape(serial, WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_CROSSHAIR);
+        else
+            m_pPointer->sendSetCursor(serial, nullptr, 0, 0);
+
+        if (FIRSTENTER)
+            markDirty();
+        else {
+            if (PREVIOUS != m_pLastSurface)
+                markDirty(PREVIOUS);
+            markDirty(m_pLastSurface);
+        }
     });
     // Adjust zoom radius or magnification with scroll (Alt modifies magnification)
     m_pPointer->setAxisDiscrete([this](CCWlPointer* r, enum wl_pointer_axis axis, int32_t discrete) {
+        if (m_bCoordsInitialized && axis == WL_POINTER_AXIS_VERTICAL_SCROLL && handleSampleScroll(discrete, true))
+            return;
         if (m_bNoZoom || !m_bCoordsInitialized)
             return;
         if (axis != WL_POINTER_AXIS_VERTICAL_SCROLL)
@@ -1180,9 +1613,11 @@ void CHyprpicker::initMouse() {
             // Toggle between base radius and 2x base
             handleRadiusToggle(steps < 0);
         }
-        markDirty();
+        markDirty(m_pLastSurface);
     });
     m_pPointer->setAxisValue120([this](CCWlPointer* r, enum wl_pointer_axis axis, int32_t value120) {
+        if (m_bCoordsInitialized && axis == WL_POINTER_AXIS_VERTICAL_SCROLL && handleSampleScroll(value120 / 120.0, true))
+            return;
         if (m_bNoZoom || !m_bCoordsInitialized)
             return;
         if (axis != WL_POINTER_AXIS_VERTICAL_SCROLL)
@@ -1199,10 +1634,12 @@ void CHyprpicker::initMouse() {
         } else {
             handleRadiusToggle(steps < 0);
         }
-        markDirty();
+        markDirty(m_pLastSurface);
     });
     // Fallback for smooth axis if discrete not provided
     m_pPointer->setAxis([this](CCWlPointer* r, uint32_t timeMs, enum wl_pointer_axis axis, wl_fixed_t value) {
+        if (m_bCoordsInitialized && axis == WL_POINTER_AXIS_VERTICAL_SCROLL && handleSampleScroll(wl_fixed_to_double(value), false))
+            return;
         if (m_bNoZoom || !m_bCoordsInitialized)
             return;
         if (axis != WL_POINTER_AXIS_VERTICAL_SCROLL)
@@ -1217,18 +1654,19 @@ void CHyprpicker::initMouse() {
         } else {
             handleRadiusToggle(v < 0);
         }
-        markDirty();
+        markDirty(m_pLastSurface);
     });
     m_pPointer->setLeave([this](CCWlPointer* r, uint32_t timeMs, wl_proxy* surface) {
         for (auto& ls : m_vLayerSurfaces) {
             if (ls->pSurface->resource() == surface) {
                 if (m_pLastSurface == ls.get())
                     m_pLastSurface = nullptr;
+
+                // drops the lens, the other monitors are unaffected
+                markDirty(ls.get());
                 break;
             }
         }
-
-        markDirty();
     });
     m_pPointer->setMotion([this](CCWlPointer* r, uint32_t timeMs, wl_fixed_t surface_x, wl_fixed_t surface_y) {
         auto x = wl_fixed_to_double(surface_x);
@@ -1238,11 +1676,13 @@ void CHyprpicker::initMouse() {
         // reset nudge on mouse movement
         m_vNudgeBufPx = {0, 0};
 
-        markDirty();
+        markDirty(m_pLastSurface);
     });
     m_pPointer->setButton([this](CCWlPointer* r, uint32_t serial, uint32_t time, uint32_t button, uint32_t button_state) {
         // Only act on press to avoid duplicate actions on release
         if (button_state == WL_POINTER_BUTTON_STATE_PRESSED) {
+            // shift decides what a click does
+            compileKeymap();
             // Mouse click: Shift-click accumulates, plain click finalizes batch
             finalizePickAtCurrent(false);
         }
@@ -3,7 +3,10 @@
 #include "defines.hpp"
 #include "helpers/LayerSurface.hpp"
 #include "helpers/PoolBuffer.hpp"
+#include "helpers/TextAtlas.hpp"
+#include "helpers/WorkerPool.hpp"
 #include <atomic>
+#include <hyprpicker/hyprpicker.hpp>
 
 enum eOutputMode {
     OUTPUT_CMYK = 0,
@@ -21,10 +24,14 @@ class CHyprpicker {
     std::mutex                                  m_mtTickMutex;
 
     SP<CCWlCompositor>                          m_pCompositor;
+    SP<CCWlSubcompositor>                       m_pSubcompositor;
     SP<CCWlRegistry>                            m_pRegistry;
     SP<CCWlShm>                                 m_pSHM;
+    std::unique_ptr<CShmArena>                  m_pShmArena;
     SP<CCZwlrLayerShellV1>                      m_pLayerShell;
     SP<CCZwlrScreencopyManagerV1>               m_pScreencopyMgr;
+    // 2 and up have copy_with_damage
+    uint32_t                                    m_iScreencopyVersion = 0;
     SP<CCWpCursorShapeManagerV1>                m_pCursorShapeMgr;
     SP<CCWpCursorShapeDeviceV1>                 m_pCursorShapeDevice;
     SP<CCWlSeat>                                m_pSeat;
@@ -32,11 +39,17 @@ class CHyprpicker {
     SP<CCWlPointer>                             m_pPointer;
     SP<CCWpFractionalScaleManagerV1>            m_pFractionalMgr;
     SP<CCWpViewporter>                          m_pViewporter;
+    SP<CCZxdgOutputManagerV1>                   m_pXDGOutputMgr;
     wl_display*                                 m_pWLDisplay = nullptr;
 
     xkb_context*                                m_pXKBContext = nullptr;
     xkb_keymap*                                 m_pXKBKeymap  = nullptr;
     xkb_state*                                  m_pXKBState   = nullptr;
+    // the keymap the compositor sent, compiled by compileKeymap() once startup is done or a key needs it
+    int                                         m_iKeymapFD   = -1;
+    uint32_t                                    m_iKeymapSize = 0;
+    // the last modifiers event, applied to a keymap compiled after it
+    uint32_t                                    m_iModsDepressed = 0, m_iModsLatched = 0, m_iModsLocked = 0, m_iModsGroup = 0;
 
     eOutputMode                                 m_bSelectedOutputMode = OUTPUT_HEX;
 
@@ -49,6 +62,56 @@ class CHyprpicker {
     bool                                        m_bNoFractional   = false;
     bool                                        m_bDisablePreview = false;
     bool                                        m_bUseLowerCase   = false;
+    bool                                        m_bPrefault       = false;
+    // draw the overlay in a small subsurface over a background attached once, instead of repainting whole buffers
+    bool                                        m_bSubsurface     = false;
+    // keep capturing what the lens shows on the monitor under the pointer, so it (and the pick) follow the screen
+    bool                                        m_bLive           = false;
+
+    // picks average (or take the median of) the pixels around the pointer, 0 takes the pixel itself.
+    // --sample-radius sets it for every pick, Ctrl-scroll changes it for the current one.
+    eSampleMode                                 m_eSampleMode         = SAMPLE_BOX;
+    int                                         m_iSampleRadiusOption = 0;
+    int                                         m_iSampleRadius       = 0;
+    // smooth scrolling left over from the last radius step, and whether the scroll in progress came with discrete steps
+    double                                      m_fSampleScroll         = 0.0;
+    bool                                        m_bSampleScrollDiscrete = false;
+
+    // --at: print the color at a global logical coordinate and exit, without any surfaces
+    bool                                        m_bPickAt = false;
+    Vector2D                                    m_vPickAt;
+
+    // --image: sample the points listed in m_szPointsPath ("-" for stdin) from an image file, without any wayland connection
+    std::string                                 m_szImagePath;
+    std::string                                 m_szPointsPath = "-";
+
+    // --watch: print the average color of a global logical rect m_fWatchRate times a second until killed, without any surfaces
+    bool                                        m_bWatch = false;
+    CBox                                        m_watchBox;
+    double                                      m_fWatchRate = 1.0;
+    // --smooth: each line is the average of this many samples, which evens out dithering and flicker
+    int                                         m_iWatchSmooth = 1;
+    // --changes: only print a line when it differs from the last one printed
+    bool                                        m_bWatchChanges = false;
+
+    // --stats: where the latency summary is written at finish(), empty if it isn't
+    std::string                                 m_szStatsPath;
+
+    // --daemon: stay connected between picks, each one started by a client on m_szSocketPath and answered to it
+    bool                                        m_bDaemon = false;
+    // --trigger: have a running daemon do the pick, and only do it here if none answers
+    bool                                        m_bTrigger = false;
+    std::string                                 m_szSocketPath;
+    int                                         m_iDaemonFD = -1;
+    // the client the current (or next) session answers to, -1 if none
+    int                                         m_iClientFD      = -1;
+    bool                                        m_bSessionActive = false;
+    // what a daemon session would have printed, sent to the client when it ends
+    std::string                                 m_szSessionOutput;
+
+    // threads used for per-pixel work, 0 = one per core
+    size_t                                      m_iThreads = 0;
+    std::unique_ptr<CWorkerPool>                m_pWorkerPool;
 
     bool                                        m_bRunning = true;
 
@@ -66,26 +129,31 @@ class CHyprpicker {
     
 
     // Keyboard repeat handling
-    std::atomic<bool>                           m_keyLeft{false}, m_keyRight{false}, m_keyUp{false}, m_keyDown{false};
-    std::atomic<int>                            m_repeatRate{0};   // chars/sec (0 or negative disables)
-    std::atomic<int>                            m_repeatDelay{600}; // ms
-    std::atomic<bool>                           m_repeatThreadRunning{false};
-    std::thread                                  m_repeatThread;
-    void                                        startRepeatThread();
+    bool                                        m_keyLeft = false, m_keyRight = false, m_keyUp = false, m_keyDown = false;
+    int                                         m_repeatRate  = 0;   // chars/sec (0 or negative disables)
+    int                                         m_repeatDelay = 600; // ms
+    // timerfd firing once per repeat while an arrow key is held, polled by the main loop
+    int                                         m_iRepeatFD    = -1;
+    bool                                        m_bRepeatArmed = false;
+    // arms or disarms the repeat timer after an arrow key changed
+    void                                        updateRepeat();
+    void                                        onRepeat();
+
+    // SIGTERM and SIGINT, polled by the main loop
+    int                                         m_iSignalFD = -1;
 
     // Zoom UI radius spring animation (source pixels before 10x scaling)
-    double                                      m_zoomRadiusTargetSrcPx = 10.0;
-    double                                      m_zoomRadiusCurrentSrcPx = 10.0;
+    double                                      m_zoomRadiusTargetSrcPx = ZOOM_RADIUS_DEFAULT;
+    double                                      m_zoomRadiusCurrentSrcPx = ZOOM_RADIUS_DEFAULT;
     double                                      m_zoomRadiusVel = 0.0; // src px / s
-    std::chrono::steady_clock::time_point       m_zoomLastTick{};
     bool                                        m_zoomAnimInitialized = false;
 
     // Zoom magnification (UI pixels per source pixel), animated for smoothness
-    double                                      m_zoomMagTarget = 10.0;   // default 10x
-    double                                      m_zoomMagCurrent = 10.0;
+    double                                      m_zoomMagTarget = ZOOM_MAG_DEFAULT;
+    double                                      m_zoomMagCurrent = ZOOM_MAG_DEFAULT;
     double                                      m_zoomMagVel = 0.0;       // ui px per src px per s
     // Base magnification for discrete toggle (ALT-scroll). Initialized on first use.
-    double                                      m_zoomMagBase = 10.0;
+    double                                      m_zoomMagBase = ZOOM_MAG_DEFAULT;
     bool                                        m_zoomMagBaseSet = false;
     // Keep UI circle size constant during ALT zoom
     bool                                        m_lockAperture = false;
@@ -94,12 +162,22 @@ class CHyprpicker {
     // Helpers to consolidate scroll handling
     void                                        handleAltToggle(bool toTriple);
     void                                        handleRadiusToggle(bool toDouble);
+    // Ctrl-scroll changes the sample radius, steps are negative when scrolling up. False if Ctrl isn't held.
+    bool                                        handleSampleScroll(double steps, bool discrete);
 
     // Base UI aperture (radius * magnification) for discrete radius toggle
     double                                      m_apertureBaseUI = 0.0;
     bool                                        m_apertureBaseSet = false;
 
     void                                        renderSurface(CLayerSurface*, bool forceInactive = false);
+    void                                        renderOverlay(CLayerSurface*, cairo_t*, const Vector2D& canvasSize, CRegion& overlay);
+    void                                        renderLens(CLayerSurface*);
+    // a spring or label is still moving towards its target
+    bool                                        animating() const;
+    // called with every frame callback: advances the animations by the time since the previous frame and keeps the
+    // active surface rendering until they settle
+    void                                        tickAnimations(CLayerSurface*, uint32_t frameTimeMs);
+    void                                        stepAnimations(double dt);
 
     int                                         createPoolFile(size_t, std::string&);
     bool                                        setCloexec(const int&);
@@ -109,28 +187,61 @@ class CHyprpicker {
 
     SP<SPoolBuffer>                             getBufferForLS(CLayerSurface*);
 
-    void                                        convertBuffer(SP<SPoolBuffer>);
-    void*                                       convert24To32Buffer(SP<SPoolBuffer>);
-
+    // every surface, for changes that affect all monitors
     void                                        markDirty();
+    // only the given surface (may be null), the others keep their last frame
+    void                                        markDirty(CLayerSurface*);
 
     void                                        finish(int code = 0);
+    // captures every monitor and maps the picker over each one as soon as its own capture is ready. startedAt is the Stats::now()
+    // time to first frame is measured from
+    void                                        startSession(uint64_t startedAt);
+    uint64_t                                    m_iSessionStartedAt = 0;
+    // a surface committed its first frame
+    void                                        onFirstFrame(CLayerSurface*);
+    // set up what the first frames don't need (keymap, cursor shape, label font), once every monitor shows its capture
+    void                                        finishStartup();
+    bool                                        m_bStartupPending = false;
+    bool                                        m_bStartupDone    = false;
+    void                                        compileKeymap();
+    // the pick is over: exits with code, or in daemon mode answers the client and has the main loop drop the session's surfaces and state
+    void                                        endSession(int code = 0);
+    void                                        teardownSession();
+    void                                        onTeardownSynced();
+    bool                                        m_bTeardownPending = false;
+    // sent after a teardown, the retired shm slots are freed when it's done
+    SP<CCWlCallback>                            m_pTeardownSync;
+    bool                                        triggerDaemon();
+    void                                        onDaemonConnection();
+    void                                        onClientReadable();
     void                                        finalizePickAtCurrent(bool forceFinalize);
+    void                                        pickAt();
+    void                                        sampleImage();
+    void                                        watch();
+
+    std::string                                 formatColor(const CColor&);
+    // prints a line of the result, or keeps it for the client in daemon mode
+    void                                        printOutput(const std::string&);
+    // a color as it is printed, in the output format and colored if the output is fancy
+    std::string                                 colorText(const CColor&);
+    // prints (and copies / notifies) a single picked color
+    void                                        outputColor(const CColor&);
 
     CColor                                      getColorFromPixel(CLayerSurface*, Vector2D);
+    // the screen buffer pixels the lens can show around the pointer, with room for the radius to grow a little
+    CBox                                        lensSourceBox(CLayerSurface*);
 
     // Multi-pick accumulation (Shift-click)
     std::vector<std::string>                    m_multiBuffer;
     bool                                        m_multiMode = false;
 
-    struct SLabelStackItem {
-        std::string text;
-        double      offsetCurrentUI = 0.0; // animated vertical offset in UI pixels
-        double      offsetTargetUI  = 0.0; // target offset in UI pixels
-    };
-    std::vector<SLabelStackItem>                m_previewStack;
-    std::chrono::steady_clock::time_point       m_uiAnimLastTick{};
-    bool                                        m_uiAnimInitialized = false;
+    std::vector<NOverlay::SStackedLabel>        m_previewStack;
+    // font of the preview labels, created on first use
+    std::unique_ptr<CTextAtlas>                 m_pLabelText;
+
+    // frame-callback time of the last animation step, in the compositor's milliseconds
+    uint32_t                                    m_animLastFrameMs = 0;
+    bool                                        m_bAnimClockValid = false;
 
   private:
 };
@@ -15,6 +15,7 @@
 #include "protocols/wlr-layer-shell-unstable-v1.hpp"
 #include "protocols/wlr-screencopy-unstable-v1.hpp"
 #include "protocols/viewporter.hpp"
+#include "protocols/xdg-output-unstable-v1.hpp"
 #include "protocols/wayland.hpp"
 
 #include <cassert>
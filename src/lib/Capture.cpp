@@ -0,0 +1,322 @@
+#include "Frame.hpp"
+
+#include "protocols/wayland.hpp"
+#include "protocols/wlr-screencopy-unstable-v1.hpp"
+#include "protocols/xdg-output-unstable-v1.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <wayland-client.h>
+
+#include <hyprutils/memory/SharedPtr.hpp>
+using namespace Hyprutils::Memory;
+
+using namespace Hyprpicker;
+
+struct SCaptureOutput {
+    SOutput                         info;
+    CSharedPointer<CCWlOutput>      output;
+    CSharedPointer<CCZxdgOutputV1>  xdgOutput;
+};
+
+struct CCapture::SImpl {
+    ~SImpl();
+
+    // into the reused buffer if reuse is set, the frame is then kept in reused (with reusedFresh set) and nullptr is returned either way
+    std::unique_ptr<CFrame>                      capture(CSharedPointer<CCZwlrScreencopyFrameV1> frame, uint32_t transform, bool reuse = false);
+    CSharedPointer<CCZwlrScreencopyFrameV1>      captureRegion(int32_t x, int32_t y, int32_t width, int32_t height, bool withCursor, uint32_t& transform);
+
+    wl_display*                                  display = nullptr;
+    std::string                                  error;
+
+    CSharedPointer<CCWlRegistry>                 registry;
+    CSharedPointer<CCWlShm>                      shm;
+    CSharedPointer<CCZwlrScreencopyManagerV1>    screencopy;
+    CSharedPointer<CCZxdgOutputManagerV1>        xdgOutputMgr;
+
+    std::vector<std::unique_ptr<SCaptureOutput>> outputs;
+    std::vector<SOutput>                         infos;
+
+    // recaptureRegion's buffer, and the frame that owns its memory. Not fresh if the last capture into it failed.
+    std::unique_ptr<CFrame>                      reused;
+    bool                                         reusedFresh = false;
+    CSharedPointer<CCWlBuffer>                   reusedBuffer;
+    uint32_t                                     reusedFormat = 0, reusedWidth = 0, reusedHeight = 0, reusedStride = 0;
+};
+
+CCapture::SImpl::~SImpl() {
+    reusedBuffer.reset();
+    reused.reset();
+    outputs.clear();
+    xdgOutputMgr.reset();
+    screencopy.reset();
+    shm.reset();
+    registry.reset();
+
+    if (display)
+        wl_display_disconnect(display);
+}
+
+CCapture::CCapture(const char* display) : m_impl(std::make_unique<SImpl>()) {
+    auto& impl = *m_impl;
+
+    impl.display = wl_display_connect(display);
+    if (!impl.display) {
+        impl.error = "No wayland compositor running";
+        return;
+    }
+
+    impl.registry = makeShared<CCWlRegistry>((wl_proxy*)wl_display_get_registry(impl.display));
+    impl.registry->setGlobal([&impl](CCWlRegistry* r, uint32_t name, const char* interface, uint32_t version) {
+        const auto BIND = [&](const wl_interface* iface, uint32_t ver) { return (wl_proxy*)wl_registry_bind((wl_registry*)r->resource(), name, iface, ver); };
+
+        if (strcmp(interface, wl_shm_interface.name) == 0)
+            impl.shm = makeShared<CCWlShm>(BIND(&wl_shm_interface, 1));
+        else if (strcmp(interface, zwlr_screencopy_manager_v1_interface.name) == 0)
+            impl.screencopy = makeShared<CCZwlrScreencopyManagerV1>(BIND(&zwlr_screencopy_manager_v1_interface, 1));
+        else if (strcmp(interface, zxdg_output_manager_v1_interface.name) == 0)
+            impl.xdgOutputMgr = makeShared<CCZxdgOutputManagerV1>(BIND(&zxdg_output_manager_v1_interface, 2));
+        else if (strcmp(interface, wl_output_interface.name) == 0) {
+            auto& output  = impl.outputs.emplace_back(std::make_unique<SCaptureOutput>());
+            output->output = makeShared<CCWlOutput>(BIND(&wl_output_interface, std::min<uint32_t>(version, 4)));
+        }
+    });
+
+    wl_display_roundtrip(impl.display);
+
+    if (!impl.shm || !impl.screencopy) {
+        impl.error = !impl.shm ? "wl_shm not supported" : "zwlr_screencopy_v1 not supported";
+        return;
+    }
+
+    for (auto& o : impl.outputs) {
+        const auto INFO = &o->info;
+
+        o->output->setGeometry([INFO](CCWlOutput* r, int32_t x, int32_t y, int32_t width_mm, int32_t height_mm, int32_t subpixel, const char* make, const char* model,
+                                      int32_t transform) { INFO->transform = transform; });
+        o->output->setScale([INFO](CCWlOutput* r, int32_t scale) { INFO->scale = scale; });
+        o->output->setName([INFO](CCWlOutput* r, const char* name) {
+            if (name)
+                INFO->name = name;
+        });
+
+        if (!impl.xdgOutputMgr)
+            continue;
+
+        o->xdgOutput = makeShared<CCZxdgOutputV1>(impl.xdgOutputMgr->sendGetXdgOutput(o->output->resource()));
+        o->xdgOutput->setLogicalPosition([INFO](CCZxdgOutputV1* r, int32_t x, int32_t y) {
+            INFO->x = x;
+            INFO->y = y;
+        });
+        o->xdgOutput->setLogicalSize([INFO](CCZxdgOutputV1* r, int32_t width, int32_t height) {
+            INFO->width  = width;
+            INFO->height = height;
+        });
+    }
+
+    wl_display_roundtrip(impl.display);
+
+    for (const auto& o : impl.outputs) {
+        impl.infos.emplace_back(o->info);
+    }
+}
+
+CCapture::~CCapture() = default;
+
+bool CCapture::good() const {
+    return m_impl->display && wl_display_get_error(m_impl->display) == 0 && m_impl->shm && m_impl->screencopy;
+}
+
+const std::string& CCapture::error() const {
+    return m_impl->error;
+}
+
+const std::vector<SOutput>& CCapture::outputs() const {
+    return m_impl->infos;
+}
+
+std::unique_ptr<CFrame> CCapture::SImpl::capture(CSharedPointer<CCZwlrScreencopyFrameV1> frame, uint32_t transform, bool reuse) {
+    uint32_t                   format = 0, width = 0, height = 0, stride = 0;
+    void*                      map     = nullptr;
+    size_t                     mapSize = 0;
+    CSharedPointer<CCWlBuffer> buffer;
+    bool                       ready = false, failed = false;
+
+    if (reuse)
+        reusedFresh = false;
+
+    frame->setBuffer([&](CCZwlrScreencopyFrameV1* r, uint32_t format_, uint32_t width_, uint32_t height_, uint32_t stride_) {
+        if (buffer || failed)
+            return;
+
+        if (reuse && reusedBuffer && format_ == reusedFormat && width_ == reusedWidth && height_ == reusedHeight && stride_ == reusedStride) {
+            format = format_;
+            width  = width_;
+            height = height_;
+            buffer = reusedBuffer;
+            r->sendCopy(buffer->resource());
+            return;
+        }
+
+        // the compositor wants something else now, the old buffer goes with the frame that maps it
+        if (reuse) {
+            reusedBuffer.reset();
+            reused.reset();
+        }
+
+        format  = format_;
+        width   = width_;
+        height  = height_;
+        stride  = stride_;
+        mapSize = (size_t)stride * height;
+
+        const int FD = memfd_create("hyprpicker", MFD_CLOEXEC);
+        if (FD < 0 || ftruncate(FD, mapSize) < 0) {
+            if (FD >= 0)
+                close(FD);
+            error  = std::format("Couldn't create a {} byte buffer: {}", mapSize, strerror(errno));
+            failed = true;
+            return;
+        }
+
+        map = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, FD, 0);
+        if (map == MAP_FAILED) {
+            close(FD);
+            map    = nullptr;
+            error  = std::format("Couldn't map a {} byte buffer: {}", mapSize, strerror(errno));
+            failed = true;
+            return;
+        }
+
+        auto pool = makeShared<CCWlShmPool>(shm->sendCreatePool(FD, mapSize));
+        buffer    = makeShared<CCWlBuffer>(pool->sendCreateBuffer(0, width, height, stride, format));
+        pool.reset();
+        close(FD);
+
+        r->sendCopy(buffer->resource());
+    });
+    frame->setReady([&](CCZwlrScreencopyFrameV1* r, uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec) { ready = true; });
+    frame->setFailed([&](CCZwlrScreencopyFrameV1* r) {
+        error  = "The compositor failed to copy the frame";
+        failed = true;
+    });
+
+    while (!ready && !failed) {
+        if (wl_display_dispatch(display) == -1) {
+            error  = "Lost the compositor while capturing";
+            failed = true;
+        }
+    }
+
+    frame.reset();
+
+    if (reuse && buffer && buffer == reusedBuffer) {
+        buffer.reset();
+
+        if (failed)
+            return nullptr;
+
+        // the same memory with new pixels, which have to be converted again
+        auto& impl  = *reused->m_impl;
+        impl.screen = std::make_unique<CScreenBuffer>(impl.map, Vector2D{(double)width, (double)height}, reusedStride, format, transform);
+        reusedFresh = true;
+        return nullptr;
+    }
+
+    if (reuse && !failed) {
+        reusedBuffer = buffer;
+        reusedFormat = format;
+        reusedWidth  = width;
+        reusedHeight = height;
+        reusedStride = stride;
+    }
+
+    buffer.reset();
+
+    auto impl     = std::make_unique<CFrame::SImpl>();
+    impl->map     = map;
+    impl->mapSize = mapSize;
+
+    if (failed)
+        return nullptr;
+
+    impl->screen = std::make_unique<CScreenBuffer>(map, Vector2D{(double)width, (double)height}, stride, format, transform);
+    if (!impl->screen->good()) {
+        error = std::format("Unsupported format {}", format);
+        reusedBuffer.reset();
+        return nullptr;
+    }
+
+    auto result = std::unique_ptr<CFrame>(new CFrame(std::move(impl)));
+    if (!reuse)
+        return result;
+
+    reused      = std::move(result);
+    reusedFresh = true;
+    return nullptr;
+}
+
+std::unique_ptr<CFrame> CCapture::captureOutput(const std::string& name, bool withCursor) {
+    if (!good())
+        return nullptr;
+
+    for (const auto& o : m_impl->outputs) {
+        if (o->info.name != name)
+            continue;
+
+        return m_impl->capture(makeShared<CCZwlrScreencopyFrameV1>(m_impl->screencopy->sendCaptureOutput(withCursor, o->output->resource())), o->info.transform);
+    }
+
+    m_impl->error = std::format("No output named {}", name);
+    return nullptr;
+}
+
+CSharedPointer<CCZwlrScreencopyFrameV1> CCapture::SImpl::captureRegion(int32_t x, int32_t y, int32_t width, int32_t height, bool withCursor, uint32_t& transform) {
+    if (!xdgOutputMgr) {
+        error = "zxdg_output_manager_v1 not supported, can't resolve global coordinates";
+        return nullptr;
+    }
+
+    for (const auto& o : outputs) {
+        const auto& INFO = o->info;
+        if (x < INFO.x || y < INFO.y || x >= INFO.x + INFO.width || y >= INFO.y + INFO.height)
+            continue;
+
+        // the region comes in the output's buffer orientation, the transform puts it upright again
+        transform = INFO.transform;
+        return makeShared<CCZwlrScreencopyFrameV1>(screencopy->sendCaptureOutputRegion(withCursor, o->output->resource(), x - INFO.x, y - INFO.y, width, height));
+    }
+
+    error = std::format("No output contains {}, {}", x, y);
+    return nullptr;
+}
+
+std::unique_ptr<CFrame> CCapture::captureRegion(int32_t x, int32_t y, int32_t width, int32_t height, bool withCursor) {
+    if (!good())
+        return nullptr;
+
+    uint32_t   transform = 0;
+    const auto FRAME     = m_impl->captureRegion(x, y, width, height, withCursor, transform);
+    if (!FRAME)
+        return nullptr;
+
+    return m_impl->capture(FRAME, transform);
+}
+
+const CFrame* CCapture::recaptureRegion(int32_t x, int32_t y, int32_t width, int32_t height, bool withCursor) {
+    if (!good())
+        return nullptr;
+
+    uint32_t   transform = 0;
+    const auto FRAME     = m_impl->captureRegion(x, y, width, height, withCursor, transform);
+    if (!FRAME)
+        return nullptr;
+
+    m_impl->capture(FRAME, transform, true);
+
+    // a failed capture leaves the previous pixels behind, they must not be handed out as new ones
+    return m_impl->reusedFresh ? m_impl->reused.get() : nullptr;
+}
@@ -0,0 +1,48 @@
+#include <hyprpicker/hyprpicker.hpp>
+
+#include "../helpers/Color.hpp"
+
+#include <format>
+
+using namespace Hyprpicker;
+
+static CColor toCColor(const SColor& color) {
+    return CColor{.r = color.r, .g = color.g, .b = color.b, .a = color.a};
+}
+
+void Hyprpicker::toHSL(const SColor& color, float& h, float& s, float& l) {
+    toCColor(color).getHSL(h, s, l);
+}
+
+void Hyprpicker::toHSV(const SColor& color, float& h, float& s, float& v) {
+    toCColor(color).getHSV(h, s, v);
+}
+
+void Hyprpicker::toCMYK(const SColor& color, float& c, float& m, float& y, float& k) {
+    toCColor(color).getCMYK(c, m, y, k);
+}
+
+std::string Hyprpicker::format(const SColor& color, eFormat fmt, bool lowercaseHex) {
+    switch (fmt) {
+        case FORMAT_HEX: return lowercaseHex ? std::format("#{:02x}{:02x}{:02x}", color.r, color.g, color.b) : std::format("#{:02X}{:02X}{:02X}", color.r, color.g, color.b);
+        case FORMAT_RGB: return std::format("{} {} {}", color.r, color.g, color.b);
+        case FORMAT_HSL:
+        case FORMAT_HSV: {
+            float h, s, l_or_v;
+            if (fmt == FORMAT_HSV)
+                toHSV(color, h, s, l_or_v);
+            else
+                toHSL(color, h, s, l_or_v);
+
+            return std::format("{} {}% {}%", h, s, l_or_v);
+        }
+        case FORMAT_CMYK: {
+            float c, m, y, k;
+            toCMYK(color, c, m, y, k);
+
+            return std::format("{}% {}% {}% {}%", c, m, y, k);
+        }
+    }
+
+    return "";
+}
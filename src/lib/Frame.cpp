@@ -0,0 +1,104 @@
+#include "Frame.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+
+using namespace Hyprpicker;
+
+CFrame::SImpl::~SImpl() {
+    // the screen buffer may still read from the memory below
+    screen.reset();
+
+    if (map)
+        munmap(map, mapSize);
+}
+
+CFrame::CFrame(std::unique_ptr<SImpl> impl) : m_impl(std::move(impl)) {}
+
+CFrame::~CFrame() = default;
+
+std::unique_ptr<CFrame> CFrame::fromMemory(const void* data, uint32_t width, uint32_t height, uint32_t stride, uint32_t shmFormat, uint32_t transform) {
+    if (!data || width == 0 || height == 0 || stride < width * NPixelConvert::bytesPerPixel(shmFormat))
+        return nullptr;
+
+    // a copy, so converting in place never touches the caller's memory
+    auto impl = std::make_unique<SImpl>();
+    impl->owned.resize((size_t)stride * height);
+    memcpy(impl->owned.data(), data, impl->owned.size());
+
+    impl->screen = std::make_unique<CScreenBuffer>(impl->owned.data(), Vector2D{(double)width, (double)height}, stride, shmFormat, transform);
+    if (!impl->screen->good())
+        return nullptr;
+
+    return std::unique_ptr<CFrame>(new CFrame(std::move(impl)));
+}
+
+std::unique_ptr<CFrame> CFrame::fromFile(const std::string& path, std::string* error) {
+    auto impl   = std::make_unique<SImpl>();
+    impl->image = std::make_unique<CImage>(path);
+
+    if (!impl->image->good()) {
+        if (error)
+            *error = impl->image->error();
+        return nullptr;
+    }
+
+    const auto& IMAGE = *impl->image;
+    impl->screen      = std::make_unique<CScreenBuffer>(IMAGE.data, IMAGE.size, IMAGE.stride, IMAGE.format, 0);
+    if (!impl->screen->good()) {
+        if (error)
+            *error = "Unsupported pixel format";
+        return nullptr;
+    }
+
+    return std::unique_ptr<CFrame>(new CFrame(std::move(impl)));
+}
+
+uint32_t CFrame::width() const {
+    return m_impl->screen->pixelSize.x;
+}
+
+uint32_t CFrame::height() const {
+    return m_impl->screen->pixelSize.y;
+}
+
+SColor CFrame::at(int x, int y) const {
+    return average(x, y, 1, 1);
+}
+
+SColor CFrame::average(int x, int y, int w, int h) const {
+    auto&     screen = *m_impl->screen;
+
+    const int X1 = std::max(0, x), Y1 = std::max(0, y);
+    const int X2 = std::min((int)screen.pixelSize.x, x + w), Y2 = std::min((int)screen.pixelSize.y, y + h);
+
+    if (X1 >= X2 || Y1 >= Y2)
+        return SColor{};
+
+    screen.ensureRect(X1, Y1, X2 - X1, Y2 - Y1);
+
+    uint64_t sum[4] = {0, 0, 0, 0};
+    for (int py = Y1; py < Y2; ++py) {
+        const auto ROW = (const uint8_t*)screen.data + (size_t)py * screen.stride;
+        for (int px = X1; px < X2; ++px) {
+            for (size_t c = 0; c < 4; ++c) {
+                sum[c] += ROW[px * 4 + c];
+            }
+        }
+    }
+
+    const uint64_t COUNT = (uint64_t)(X2 - X1) * (Y2 - Y1);
+    const auto     AVG   = [&](size_t c) { return (uint8_t)((sum[c] + COUNT / 2) / COUNT); };
+
+    return SColor{.r = AVG(2), .g = AVG(1), .b = AVG(0), .a = AVG(3)};
+}
+
+const uint8_t* CFrame::pixels() const {
+    m_impl->screen->ensureAll();
+    return (const uint8_t*)m_impl->screen->data;
+}
+
+uint32_t CFrame::stride() const {
+    return m_impl->screen->stride;
+}
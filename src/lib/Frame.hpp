@@ -0,0 +1,18 @@
+#pragma once
+
+#include <hyprpicker/hyprpicker.hpp>
+
+#include "../helpers/Image.hpp"
+#include "../helpers/ScreenBuffer.hpp"
+
+struct Hyprpicker::CFrame::SImpl {
+    ~SImpl();
+
+    // the pixels screen reads from, one of these
+    std::vector<uint8_t>           owned;
+    std::unique_ptr<CImage>        image;
+    void*                          map     = nullptr;
+    size_t                         mapSize = 0;
+
+    std::unique_ptr<CScreenBuffer> screen;
+};
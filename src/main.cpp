@@ -1,9 +1,37 @@
 #include <strings.h>
 
+#include <charconv>
 #include <iostream>
 
 #include "hyprpicker.hpp"
 
+// options without a short form
+enum eLongOption {
+    OPT_AT = 256,
+    OPT_PREFAULT,
+    OPT_SUBSURFACE,
+    OPT_STATS,
+    OPT_IMAGE,
+    OPT_POINTS,
+    OPT_DAEMON,
+    OPT_TRIGGER,
+    OPT_LIVE,
+    OPT_WATCH,
+    OPT_RATE,
+    OPT_SMOOTH,
+    OPT_CHANGES,
+    OPT_SAMPLE,
+    OPT_SAMPLE_RADIUS,
+};
+
+// all of arg as a number. Unlike std::stoi, "4abc" or "2.5" for an int is an error rather than 4 or 2.
+template <typename T>
+static bool parseNumber(const char* arg, T& out) {
+    const char* end      = arg + strlen(arg);
+    const auto [ptr, ec] = std::from_chars(arg, end, out);
+    return ec == std::errc{} && ptr != arg && ptr == end;
+}
+
 static void help() {
     std::cout << "Hyprpicker usage: hyprpicker [arg [...]].\n\nArguments:\n"
               << " -a | --autocopy            | Automatically copies the output to the clipboard (requires wl-clipboard)\n"
@@ -18,6 +46,22 @@ static void help() {
               << " -t | --no-fractional       | Disable fractional scaling support\n"
               << " -d | --disable-preview     | Disable live preview of color\n"
               << " -l | --lowercase-hex       | Outputs the hexcode in lowercase\n"
+              << " -j | --threads=n           | Number of threads used for converting captures (default: one per core)\n"
+              << "      --at=x,y              | Print the color at a global (logical) coordinate and exit, without the picker UI\n"
+              << "      --image=file          | Print the colors at the points listed by --points in a PPM, PAM, farbfeld or JPEG image, without the picker UI\n"
+              << "      --points=file         | Points (x y) and rects to average (x y w h) for --image, one per line (default: - for stdin)\n"
+              << "      --sample=mode         | How picks with a radius combine pixels: box (average), circle (average) or median (default: box)\n"
+              << "      --sample-radius=n     | Pick from the pixels up to n away instead of just one, Ctrl-scroll changes it while picking (default: 0)\n"
+              << "      --watch=x,y[,w,h]     | Keep printing the (average) color at a global (logical) point or rect, with a timestamp, without the picker UI\n"
+              << "      --rate=hz             | Samples per second for --watch (default: 1)\n"
+              << "      --smooth=n            | Print the average of the last n samples with --watch, to even out dithering (1 to 1000, default: 1)\n"
+              << "      --changes             | Only print a line with --watch when the color changed\n"
+              << "      --subsurface          | Draw the lens in a subsurface over a static background (less work per frame on large outputs)\n"
+              << "      --live                | Keep re-capturing around the pointer, so the lens and the pick follow videos and games\n"
+              << "      --prefault            | Fault in shared memory buffers when they are created instead of on first use\n"
+              << "      --stats=path          | Write per-stage latencies (p50 / p95 / p99, per monitor) as JSON to path on exit\n"
+              << "      --daemon              | Stay connected and pick whenever --trigger asks, with the options given here (output is never fancy)\n"
+              << "      --trigger             | Have a running --daemon do the pick and print its result, or pick here if none is running\n"
               << " -V | --version             | Print version info\n";
 }
 
@@ -38,10 +82,26 @@ int main(int argc, char** argv, char** envp) {
                                                {"verbose", no_argument, nullptr, 'v'},
                                                {"disable-preview", no_argument, nullptr, 'd'},
                                                {"lowercase-hex", no_argument, nullptr, 'l'},
+                                               {"threads", required_argument, nullptr, 'j'},
+                                               {"at", required_argument, nullptr, OPT_AT},
+                                               {"prefault", no_argument, nullptr, OPT_PREFAULT},
+                                               {"subsurface", no_argument, nullptr, OPT_SUBSURFACE},
+                                               {"live", no_argument, nullptr, OPT_LIVE},
+                                               {"stats", required_argument, nullptr, OPT_STATS},
+                                               {"image", required_argument, nullptr, OPT_IMAGE},
+                                               {"points", required_argument, nullptr, OPT_POINTS},
+                                               {"sample", required_argument, nullptr, OPT_SAMPLE},
+                                               {"sample-radius", required_argument, nullptr, OPT_SAMPLE_RADIUS},
+                                               {"watch", required_argument, nullptr, OPT_WATCH},
+                                               {"rate", required_argument, nullptr, OPT_RATE},
+                                               {"smooth", required_argument, nullptr, OPT_SMOOTH},
+                                               {"changes", no_argument, nullptr, OPT_CHANGES},
+                                               {"daemon", no_argument, nullptr, OPT_DAEMON},
+                                               {"trigger", no_argument, nullptr, OPT_TRIGGER},
                                                {"version", no_argument, nullptr, 'V'},
                                                {nullptr, 0, nullptr, 0}};
 
-        int                  c = getopt_long(argc, argv, ":f:hnbarzqvtdlV", long_options, &option_index);
+        int                  c = getopt_long(argc, argv, ":f:hnbarzqvtdlVj:", long_options, &option_index);
         if (c == -1)
             break;
 
@@ -73,6 +133,112 @@ int main(int argc, char** argv, char** envp) {
             case 'v': Debug::verbose = true; break;
             case 'd': g_pHyprpicker->m_bDisablePreview = true; break;
             case 'l': g_pHyprpicker->m_bUseLowerCase = true; break;
+            case 'j': {
+                int threads = 0;
+                if (!parseNumber(optarg, threads) || threads < 1) {
+                    Debug::log(NONE, "Invalid thread count %s, expected a positive integer", optarg);
+                    exit(1);
+                }
+                g_pHyprpicker->m_iThreads = threads;
+                break;
+            }
+            case OPT_AT: {
+                const std::string ARG   = optarg;
+                const auto        COMMA = ARG.find(',');
+                try {
+                    if (COMMA == std::string::npos)
+                        throw std::invalid_argument("missing comma");
+                    size_t     endX = 0, endY = 0;
+                    const auto X    = std::stoi(ARG.substr(0, COMMA), &endX);
+                    const auto Y    = std::stoi(ARG.substr(COMMA + 1), &endY);
+                    if (endX != COMMA || endY != ARG.length() - COMMA - 1)
+                        throw std::invalid_argument("trailing characters");
+                    g_pHyprpicker->m_bPickAt = true;
+                    g_pHyprpicker->m_vPickAt = {(double)X, (double)Y};
+                } catch (std::exception& e) {
+                    Debug::log(NONE, "Invalid coordinates %s, expected x,y", optarg);
+                    exit(1);
+                }
+                break;
+            }
+            case OPT_SAMPLE:
+                if (strcasecmp(optarg, "box") == 0)
+                    g_pHyprpicker->m_eSampleMode = SAMPLE_BOX;
+                else if (strcasecmp(optarg, "circle") == 0)
+                    g_pHyprpicker->m_eSampleMode = SAMPLE_CIRCLE;
+                else if (strcasecmp(optarg, "median") == 0)
+                    g_pHyprpicker->m_eSampleMode = SAMPLE_MEDIAN;
+                else {
+                    Debug::log(NONE, "Unrecognized sample mode %s", optarg);
+                    exit(1);
+                }
+                break;
+            case OPT_SAMPLE_RADIUS: {
+                int radius = 0;
+                if (!parseNumber(optarg, radius) || radius < 0 || radius > SAMPLE_RADIUS_MAX) {
+                    Debug::log(NONE, "Invalid sample radius %s, expected 0 to %d", optarg, SAMPLE_RADIUS_MAX);
+                    exit(1);
+                }
+                g_pHyprpicker->m_iSampleRadiusOption = radius;
+                g_pHyprpicker->m_iSampleRadius       = radius;
+                break;
+            }
+            case OPT_WATCH: {
+                // x,y or x,y,w,h
+                int         values[4] = {0, 0, 1, 1};
+                size_t      count     = 0;
+                const char* it        = optarg;
+                const char* end       = optarg + strlen(optarg);
+                bool        valid     = true;
+                while (valid && count < 4) {
+                    const auto [ptr, ec] = std::from_chars(it, end, values[count]);
+                    valid                = ec == std::errc{} && ptr != it;
+                    count++;
+                    it = ptr;
+                    if (it == end || *it != ',')
+                        break;
+                    it++;
+                }
+
+                if (!valid || it != end || (count != 2 && count != 4) || values[2] <= 0 || values[3] <= 0) {
+                    Debug::log(NONE, "Invalid region %s, expected x,y or x,y,w,h", optarg);
+                    exit(1);
+                }
+
+                g_pHyprpicker->m_bWatch   = true;
+                g_pHyprpicker->m_watchBox = {(double)values[0], (double)values[1], (double)values[2], (double)values[3]};
+                break;
+            }
+            case OPT_RATE: {
+                double rate = 0;
+                if (!parseNumber(optarg, rate) || !(rate > 0 && rate <= WATCH_RATE_MAX)) {
+                    Debug::log(NONE, "Invalid rate %s, expected up to %g samples per second", optarg, WATCH_RATE_MAX);
+                    exit(1);
+                }
+                g_pHyprpicker->m_fWatchRate = rate;
+                break;
+            }
+            case OPT_SMOOTH: {
+                int samples = 0;
+                if (!parseNumber(optarg, samples) || samples < 1 || samples > WATCH_SMOOTH_MAX) {
+                    Debug::log(NONE, "Invalid sample count %s, expected 1 to %d", optarg, WATCH_SMOOTH_MAX);
+                    exit(1);
+                }
+                g_pHyprpicker->m_iWatchSmooth = samples;
+                break;
+            }
+            case OPT_CHANGES: g_pHyprpicker->m_bWatchChanges = true; break;
+            case OPT_PREFAULT: g_pHyprpicker->m_bPrefault = true; break;
+            case OPT_SUBSURFACE: g_pHyprpicker->m_bSubsurface = true; break;
+            case OPT_LIVE: g_pHyprpicker->m_bLive = true; break;
+            case OPT_IMAGE: g_pHyprpicker->m_szImagePath = optarg; break;
+            case OPT_POINTS: g_pHyprpicker->m_szPointsPath = optarg; break;
+            case OPT_DAEMON: g_pHyprpicker->m_bDaemon = true; break;
+            case OPT_TRIGGER: g_pHyprpicker->m_bTrigger = true; break;
+            case OPT_STATS:
+                g_pHyprpicker->m_szStatsPath = optarg;
+                Stats::enabled               = true;
+                break;
             case 'V': {
                 std::cout << "hyprpicker v" << HYPRPICKER_VERSION << "\n";
                 exit(0);
@@ -82,6 +248,12 @@ int main(int argc, char** argv, char** envp) {
         }
     }
 
+    // init() runs the first of these it finds, the others would be ignored without a word
+    if (g_pHyprpicker->m_bWatch && (g_pHyprpicker->m_bPickAt || !g_pHyprpicker->m_szImagePath.empty() || g_pHyprpicker->m_bDaemon || g_pHyprpicker->m_bTrigger)) {
+        Debug::log(NONE, "--watch can't be combined with --at, --image, --daemon or --trigger");
+        exit(1);
+    }
+
     if (!isatty(fileno(stdout)) || getenv("NO_COLOR"))
         g_pHyprpicker->m_bFancyOutput = false;
 
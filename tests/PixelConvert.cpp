@@ -0,0 +1,284 @@
+// Checks every conversion backend this CPU can run against the per-pixel loops hyprpicker used before the row kernels,
+// and the transforming frame conversion against a per-pixel mapping of the output transforms.
+// Exits non-zero on the first mismatch.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <print>
+#include <utility>
+#include <vector>
+#include <wayland-client.h>
+
+#include "tests/Synthetic.hpp"
+#include "src/helpers/PixelConvert.hpp"
+
+// odd and off-by-one lengths around every vector width, so the scalar tails get exercised
+constexpr size_t LENGTHS[] = {1, 3, 5, 7, 9, 15, 17, 31, 33, 63, 65, 127, 129, 1021, 1023, 1025};
+
+// CHyprpicker::convertBuffer as it was, for one row of a 4-byte format, in place
+static void oldConvertBuffer(uint8_t* data, size_t count, uint32_t format) {
+    switch (format) {
+        case WL_SHM_FORMAT_ARGB8888:
+        case WL_SHM_FORMAT_XRGB8888: break;
+        case WL_SHM_FORMAT_ABGR8888:
+        case WL_SHM_FORMAT_XBGR8888: {
+            for (size_t x = 0; x < count; ++x) {
+                struct SPixel {
+                    // little-endian ARGB
+                    unsigned char blue;
+                    unsigned char green;
+                    unsigned char red;
+                    unsigned char alpha;
+                }* px = (struct SPixel*)(data + (x * 4));
+
+                std::swap(px->red, px->blue);
+            }
+        } break;
+        case WL_SHM_FORMAT_XRGB2101010:
+        case WL_SHM_FORMAT_XBGR2101010: {
+            const bool FLIP = format == WL_SHM_FORMAT_XBGR2101010;
+
+            for (size_t x = 0; x < count; ++x) {
+                uint32_t* px = (uint32_t*)(data + (x * 4));
+
+                // conv to 8 bit
+                uint8_t R = (uint8_t)std::round((255.0 * (((*px) & 0b00000000000000000000001111111111) >> 0) / 1023.0));
+                uint8_t G = (uint8_t)std::round((255.0 * (((*px) & 0b00000000000011111111110000000000) >> 10) / 1023.0));
+                uint8_t B = (uint8_t)std::round((255.0 * (((*px) & 0b00111111111100000000000000000000) >> 20) / 1023.0));
+                uint8_t A = (uint8_t)std::round((255.0 * (((*px) & 0b11000000000000000000000000000000) >> 30) / 3.0));
+
+                // write 8-bit values
+                *px = ((FLIP ? B : R) << 0) + (G << 8) + ((FLIP ? R : B) << 16) + (A << 24);
+            }
+        } break;
+        default: break;
+    }
+}
+
+// CHyprpicker::convert24To32Buffer as it was, for one row
+static void oldConvert24To32Buffer(const uint8_t* src, uint8_t* dst, size_t count, uint32_t format) {
+    switch (format) {
+        case WL_SHM_FORMAT_BGR888: {
+            for (size_t x = 0; x < count; ++x) {
+                struct SPixel3 {
+                    // little-endian RGB
+                    unsigned char blue;
+                    unsigned char green;
+                    unsigned char red;
+                }* srcPx = (struct SPixel3*)(src + (x * 3));
+                struct SPixel4 {
+                    // little-endian ARGB
+                    unsigned char blue;
+                    unsigned char green;
+                    unsigned char red;
+                    unsigned char alpha;
+                }* dstPx = (struct SPixel4*)(dst + (x * 4));
+                *dstPx   = {.blue = srcPx->red, .green = srcPx->green, .red = srcPx->blue, .alpha = 0xFF};
+            }
+        } break;
+        case WL_SHM_FORMAT_RGB888: {
+            for (size_t x = 0; x < count; ++x) {
+                struct SPixel3 {
+                    // big-endian RGB
+                    unsigned char red;
+                    unsigned char green;
+                    unsigned char blue;
+                }* srcPx = (struct SPixel3*)(src + (x * 3));
+                struct SPixel4 {
+                    // big-endian ARGB
+                    unsigned char alpha;
+                    unsigned char red;
+                    unsigned char green;
+                    unsigned char blue;
+                }* dstPx = (struct SPixel4*)(dst + (x * 4));
+                *dstPx   = {.alpha = 0xFF, .red = srcPx->red, .green = srcPx->green, .blue = srcPx->blue};
+            }
+        } break;
+        default: break;
+    }
+}
+
+// every 10-bit value in every channel, and every alpha, with the channels out of step so no two pixels repeat a combination
+static std::vector<uint8_t> all10BitValues() {
+    std::vector<uint8_t> data(1024 * 4);
+
+    for (uint32_t v = 0; v < 1024; ++v) {
+        const uint32_t PX = (v << 0) | (((v * 7) & 1023) << 10) | ((1023 - v) << 20) | ((v & 3) << 30);
+        std::memcpy(data.data() + (v * 4), &PX, 4);
+    }
+
+    return data;
+}
+
+// converts count pixels of src with the current backend and the old loops, both out of place and (for 4-byte formats) in place
+static bool check(const std::vector<uint8_t>& src, size_t count, const SFormat& format, const char* what) {
+    const uint32_t       BPP = NPixelConvert::bytesPerPixel(format.format);
+
+    std::vector<uint8_t> expected(count * 4);
+    if (BPP == 4) {
+        std::memcpy(expected.data(), src.data(), count * 4);
+        oldConvertBuffer(expected.data(), count, format.format);
+    } else
+        oldConvert24To32Buffer(src.data(), expected.data(), count, format.format);
+
+    // one pixel of slack before and after the row, to catch a kernel writing past its ends
+    std::vector<uint32_t> out(count + 2, 0xDEADBEEF);
+    NPixelConvert::convertRow(src.data(), out.data() + 1, count, format.format);
+
+    bool ok = out.front() == 0xDEADBEEF && out.back() == 0xDEADBEEF && std::memcmp(out.data() + 1, expected.data(), count * 4) == 0;
+
+    if (ok && BPP == 4) {
+        std::vector<uint32_t> inPlace(count);
+        std::memcpy(inPlace.data(), src.data(), count * 4);
+        NPixelConvert::convertRow((const uint8_t*)inPlace.data(), inPlace.data(), count, format.format);
+        ok = std::memcmp(inPlace.data(), expected.data(), count * 4) == 0;
+    }
+
+    if (!ok)
+        std::println(stderr, "{}: {} differs from the old conversion on {} ({} pixels)", NPixelConvert::backendName(NPixelConvert::backend()), format.name, what, count);
+
+    return ok;
+}
+
+// frame sizes around the 64 pixel tiles of the rotating path, and a few odd ones
+constexpr std::pair<uint32_t, uint32_t> FRAME_SIZES[] = {{1, 1}, {7, 3}, {3, 7}, {63, 64}, {64, 65}, {65, 63}, {64, 64}, {130, 67}};
+
+constexpr uint32_t                      UNTOUCHED = 0xDEADBEEF;
+
+// Where destination pixel (dx, dy) of a transformed W x H frame comes from: mirror x back for the flipped variants,
+// then undo the rotation. Rotations are the ones cairo used to paint captures with.
+static std::pair<uint32_t, uint32_t> sourceOf(uint32_t transform, uint32_t W, uint32_t H, uint32_t dx, uint32_t dy) {
+    const uint32_t DSTWIDTH = (transform & 1) ? H : W;
+
+    if (transform & 4)
+        dx = DSTWIDTH - 1 - dx;
+
+    switch (transform & 3) {
+        case 1: return {dy, H - 1 - dx};
+        case 2: return {W - 1 - dx, H - 1 - dy};
+        case 3: return {W - 1 - dy, dx};
+        default: return {dx, dy};
+    }
+}
+
+// the whole frame through the old loops, untransformed
+static std::vector<uint32_t> oldConvertFrame(const std::vector<uint8_t>& data, uint32_t W, uint32_t H, uint32_t stride, uint32_t format) {
+    std::vector<uint32_t> frame((size_t)W * H);
+
+    for (uint32_t y = 0; y < H; ++y) {
+        uint8_t* row = (uint8_t*)(frame.data() + ((size_t)y * W));
+        if (NPixelConvert::bytesPerPixel(format) == 4) {
+            std::memcpy(row, data.data() + ((size_t)y * stride), (size_t)W * 4);
+            oldConvertBuffer(row, W, format);
+        } else
+            oldConvert24To32Buffer(data.data() + ((size_t)y * stride), row, W, format);
+    }
+
+    return frame;
+}
+
+// convertRect of [x0, x1) x [y0, y1) (convertFrame when whole) against the per-pixel mapping: converted pixels from inside the rect,
+// everything else including the stride padding left alone
+static bool checkRect(const std::vector<uint8_t>& data, const std::vector<uint32_t>& reference, uint32_t W, uint32_t H, uint32_t stride, const SFormat& format,
+                      uint32_t transform, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, bool whole) {
+    const uint32_t        DSTW = (transform & 1) ? H : W, DSTH = (transform & 1) ? W : H;
+    const uint32_t        DSTSTRIDE = DSTW + 3;
+
+    std::vector<uint32_t> out((size_t)DSTSTRIDE * DSTH, UNTOUCHED);
+
+    const NPixelConvert::SFrame FRAME = {.data = data.data(), .width = W, .height = H, .stride = stride, .format = format.format};
+    if (whole)
+        NPixelConvert::convertFrame(FRAME, (uint8_t*)out.data(), DSTSTRIDE * 4, transform);
+    else
+        NPixelConvert::convertRect(FRAME, (uint8_t*)out.data(), DSTSTRIDE * 4, transform, x0, y0, x1, y1);
+
+    for (uint32_t dy = 0; dy < DSTH; ++dy) {
+        for (uint32_t dx = 0; dx < DSTSTRIDE; ++dx) {
+            uint32_t expected = UNTOUCHED;
+            if (dx < DSTW) {
+                const auto [SX, SY] = sourceOf(transform, W, H, dx, dy);
+                if (SX >= x0 && SX < x1 && SY >= y0 && SY < y1)
+                    expected = reference[(size_t)SY * W + SX];
+            }
+
+            if (out[(size_t)dy * DSTSTRIDE + dx] != expected) {
+                std::println(stderr, "{}: {} {}x{} transform {} rect {},{} - {},{} differs at destination {},{}", NPixelConvert::backendName(NPixelConvert::backend()),
+                             format.name, W, H, transform, x0, y0, x1, y1, dx, dy);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// every transform of every frame size, whole and in sub-rects that cut through tiles, plus NORMAL in place
+static bool checkFrames(const SFormat& format) {
+    const uint32_t BPP = NPixelConvert::bytesPerPixel(format.format);
+    bool           ok  = true;
+
+    for (const auto& [W, H] : FRAME_SIZES) {
+        // padded, so a kernel reading the stride as the width shows up
+        const uint32_t STRIDE    = W * BPP + 8;
+        const auto     DATA      = randomBytes((size_t)STRIDE * H, W * 131 + H);
+        const auto     REFERENCE = oldConvertFrame(DATA, W, H, STRIDE, format.format);
+
+        for (uint32_t transform = 0; transform < 8 && ok; ++transform) {
+            ok &= checkRect(DATA, REFERENCE, W, H, STRIDE, format, transform, 0, 0, W, H, true);
+            ok &= checkRect(DATA, REFERENCE, W, H, STRIDE, format, transform, W / 3, H / 3, 2 * W / 3 + 1, 2 * H / 3 + 1, false);
+            ok &= checkRect(DATA, REFERENCE, W, H, STRIDE, format, transform, 1, H / 2, W, H / 2 + 1, false);
+            // past the frame, which gets clipped
+            ok &= checkRect(DATA, REFERENCE, W, H, STRIDE, format, transform, W / 2, 0, W + 10, H + 10, false);
+        }
+
+        if (ok && BPP == 4) {
+            auto inPlace = DATA;
+            NPixelConvert::convertFrame({.data = inPlace.data(), .width = W, .height = H, .stride = STRIDE, .format = format.format}, inPlace.data(), STRIDE,
+                                        WL_OUTPUT_TRANSFORM_NORMAL);
+
+            for (uint32_t y = 0; y < H && ok; ++y) {
+                ok = std::memcmp(inPlace.data() + ((size_t)y * STRIDE), REFERENCE.data() + ((size_t)y * W), (size_t)W * 4) == 0 &&
+                    std::memcmp(inPlace.data() + ((size_t)y * STRIDE) + ((size_t)W * 4), DATA.data() + ((size_t)y * STRIDE) + ((size_t)W * 4), 8) == 0;
+            }
+
+            if (!ok)
+                std::println(stderr, "{}: {} {}x{} differs converted in place", NPixelConvert::backendName(NPixelConvert::backend()), format.name, W, H);
+        }
+    }
+
+    return ok;
+}
+
+int main() {
+    const auto ALL10BIT = all10BitValues();
+    bool       ok       = true;
+
+    for (int b = NPixelConvert::BACKEND_SCALAR; b <= NPixelConvert::BACKEND_AVX2; ++b) {
+        const auto BACKEND = (NPixelConvert::eBackend)b;
+
+        if (!NPixelConvert::setBackend(BACKEND)) {
+            std::println("{}: not supported by this CPU, skipped", NPixelConvert::backendName(BACKEND));
+            continue;
+        }
+
+        for (const auto& format : FORMATS) {
+            const uint32_t BPP = NPixelConvert::bytesPerPixel(format.format);
+
+            for (const size_t count : LENGTHS) {
+                ok &= check(randomBytes(count * BPP, 0x9E3779B9 ^ (uint32_t)count), count, format, "random data");
+            }
+
+            if (BPP == 4) {
+                ok &= check(ALL10BIT, 1024, format, "all 10-bit values");
+                ok &= check(ALL10BIT, 1023, format, "all 10-bit values");
+            }
+
+            ok &= checkFrames(format);
+        }
+
+        std::println("{}: {}", NPixelConvert::backendName(BACKEND), ok ? "ok" : "FAILED");
+    }
+
+    return ok ? 0 : 1;
+}
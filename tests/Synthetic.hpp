@@ -0,0 +1,33 @@
+#pragma once
+
+// Input for the tests and hyprpicker-bench: the wl_shm formats the capture conversion handles, and noise to fill frames with.
+
+#include <cstdint>
+#include <vector>
+#include <wayland-client.h>
+
+struct SFormat {
+    uint32_t    format;
+    const char* name;
+};
+
+inline constexpr SFormat FORMATS[] = {
+    {WL_SHM_FORMAT_XRGB8888, "XRGB8888"},       {WL_SHM_FORMAT_ARGB8888, "ARGB8888"}, {WL_SHM_FORMAT_XBGR8888, "XBGR8888"},
+    {WL_SHM_FORMAT_ABGR8888, "ABGR8888"},       {WL_SHM_FORMAT_XRGB2101010, "XRGB2101010"}, {WL_SHM_FORMAT_XBGR2101010, "XBGR2101010"},
+    {WL_SHM_FORMAT_BGR888, "BGR888"},           {WL_SHM_FORMAT_RGB888, "RGB888"},
+};
+
+// xorshift noise, so no kernel gets an easy ride on uniform data. The same seed gives the same bytes, 0 is taken as 1.
+inline std::vector<uint8_t> randomBytes(size_t size, uint32_t seed) {
+    std::vector<uint8_t> data(size);
+
+    uint32_t             state = seed ? seed : 1;
+    for (auto& b : data) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        b = (uint8_t)state;
+    }
+
+    return data;
+}